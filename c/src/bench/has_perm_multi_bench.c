@@ -0,0 +1,142 @@
+#include "../lib/perms.h"
+#include "../lib/perm_index.h"
+#include "../lib/kc_string.h"
+#include "../lib/alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Benchmarks checking one permission against many staff members:
+// the naive kittycat_has_perm loop vs KittycatPermissionListBatch vs compiled KittycatPermissionSets
+//
+// Usage: has_perm_multi_bench [users] [perms per user] [iterations]
+
+static const char *namespaces[] = {"rpc", "apps", "bot", "global"};
+
+struct KittycatPermissionList *random_user(size_t perms_per_user)
+{
+    struct KittycatPermissionList *pl = kittycat_permission_list_new();
+
+    for (size_t i = 0; i < perms_per_user; i++)
+    {
+        char buf[64];
+        int r = rand();
+        const char *ns = namespaces[r % 3];
+        int len;
+
+        if (r % 97 == 0)
+        {
+            len = snprintf(buf, sizeof(buf), "%s.*", ns);
+        }
+        else if (r % 5 == 0)
+        {
+            len = snprintf(buf, sizeof(buf), "~%s.Perm%d", ns, (r >> 8) % 60);
+        }
+        else
+        {
+            len = snprintf(buf, sizeof(buf), "%s.Perm%d", ns, (r >> 8) % 60);
+        }
+
+        struct kittycat_string *perm_str = kittycat_string_new(buf, len);
+        kittycat_permission_list_add(pl, kittycat_permission_new_from_str(perm_str));
+        kittycat_string_free(perm_str);
+    }
+
+    return pl;
+}
+
+double elapsed_ms(clock_t start)
+{
+    return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+    kittycat_set_allocator(malloc, realloc, free, memcpy);
+
+    size_t users = argc > 1 ? (size_t)atol(argv[1]) : 5000;
+    size_t perms_per_user = argc > 2 ? (size_t)atol(argv[2]) : 24;
+    size_t iterations = argc > 3 ? (size_t)atol(argv[3]) : 200;
+
+    srand(42);
+
+    struct KittycatPermissionList **lists = malloc(users * sizeof(struct KittycatPermissionList *));
+    struct KittycatPermissionSet **sets = malloc(users * sizeof(struct KittycatPermissionSet *));
+    for (size_t i = 0; i < users; i++)
+    {
+        lists[i] = random_user(perms_per_user);
+        sets[i] = kittycat_permission_set_compile(lists[i]);
+    }
+
+    struct KittycatPermissionListBatch *batch = kittycat_permission_list_batch_new((const struct KittycatPermissionList *const *)lists, users);
+
+    struct kittycat_string *query_str = kittycat_string_new("rpc.Perm7", 9);
+    struct KittycatPermission *query = kittycat_permission_new_from_str(query_str);
+
+    size_t words = (users + 63) / 64;
+    uint64_t *naive_out = calloc(words, sizeof(uint64_t));
+    uint64_t *batch_out = calloc(words, sizeof(uint64_t));
+    uint64_t *sets_out = calloc(words, sizeof(uint64_t));
+
+    clock_t start = clock();
+    for (size_t it = 0; it < iterations; it++)
+    {
+        memset(naive_out, 0, words * sizeof(uint64_t));
+        for (size_t i = 0; i < users; i++)
+        {
+            if (kittycat_has_perm(lists[i], query))
+            {
+                naive_out[i / 64] |= (uint64_t)1 << (i % 64);
+            }
+        }
+    }
+    double naive_ms = elapsed_ms(start);
+
+    start = clock();
+    for (size_t it = 0; it < iterations; it++)
+    {
+        kittycat_permission_list_batch_has_perm(batch, query, batch_out);
+    }
+    double batch_ms = elapsed_ms(start);
+
+    start = clock();
+    for (size_t it = 0; it < iterations; it++)
+    {
+        kittycat_permission_sets_has_perm((const struct KittycatPermissionSet *const *)sets, users, query, sets_out);
+    }
+    double sets_ms = elapsed_ms(start);
+
+    size_t granted = 0;
+    for (size_t i = 0; i < users; i++)
+    {
+        granted += (naive_out[i / 64] >> (i % 64)) & 1;
+    }
+
+    printf("%zu users, %zu perms each, %zu iterations, %zu granted, SIMD level %d\n", users, perms_per_user, iterations, granted, (int)kittycat_simd_level());
+    printf("naive kittycat_has_perm loop:    %8.2f ms (%6.1f ns/user)\n", naive_ms, naive_ms * 1e6 / (double)(users * iterations));
+    printf("KittycatPermissionListBatch:     %8.2f ms (%6.1f ns/user)\n", batch_ms, batch_ms * 1e6 / (double)(users * iterations));
+    printf("compiled KittycatPermissionSets: %8.2f ms (%6.1f ns/user)\n", sets_ms, sets_ms * 1e6 / (double)(users * iterations));
+
+    int rc = 0;
+    if (memcmp(naive_out, batch_out, words * sizeof(uint64_t)) != 0 || memcmp(naive_out, sets_out, words * sizeof(uint64_t)) != 0)
+    {
+        fprintf(stderr, "ERROR: results differ from the naive loop\n");
+        rc = 1;
+    }
+
+    free(naive_out);
+    free(batch_out);
+    free(sets_out);
+    kittycat_permission_free(query);
+    kittycat_string_free(query_str);
+    kittycat_permission_list_batch_free(batch);
+    for (size_t i = 0; i < users; i++)
+    {
+        kittycat_permission_set_free(sets[i]);
+        kittycat_permission_list_free(lists[i]);
+    }
+    free(sets);
+    free(lists);
+
+    return rc;
+}
@@ -0,0 +1,132 @@
+// clock_gettime is POSIX, which strict C99 builds hide unless asked for
+#define _POSIX_C_SOURCE 200809L
+
+#include "../lib/perms.h"
+#include "../lib/kc_string.h"
+#include "../lib/alloc.h"
+#include "../lib/resolve_batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Benchmarks resolving the permissions of many staff members at startup:
+// a serial kittycat_staff_permissions_resolve loop vs kittycat_staff_permissions_resolve_batch with 1, 2, 4, ... threads
+//
+// Usage: resolve_batch_bench [users] [positions per user] [max threads]
+
+static const char *namespaces[] = {"rpc", "apps", "bot", "global"};
+
+struct KittycatPermissionList *random_perms(size_t len)
+{
+    struct KittycatPermissionList *pl = kittycat_permission_list_new();
+
+    for (size_t i = 0; i < len; i++)
+    {
+        char buf[64];
+        int r = rand();
+        const char *ns = namespaces[r % 3];
+        int n;
+
+        if (r % 97 == 0)
+        {
+            n = snprintf(buf, sizeof(buf), "%s.*", ns);
+        }
+        else if (r % 5 == 0)
+        {
+            n = snprintf(buf, sizeof(buf), "~%s.Perm%d", ns, (r >> 8) % 60);
+        }
+        else
+        {
+            n = snprintf(buf, sizeof(buf), "%s.Perm%d", ns, (r >> 8) % 60);
+        }
+
+        struct kittycat_string *perm_str = kittycat_string_new(buf, n);
+        kittycat_permission_list_add(pl, kittycat_permission_new_from_str(perm_str));
+        kittycat_string_free(perm_str);
+    }
+
+    return pl;
+}
+
+double now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+void free_results(struct KittycatPermissionList **out, size_t users)
+{
+    for (size_t i = 0; i < users; i++)
+    {
+        kittycat_permission_list_free(out[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    kittycat_set_allocator(malloc, realloc, free, memcpy);
+
+    size_t users = argc > 1 ? (size_t)atol(argv[1]) : 20000;
+    size_t positions_per_user = argc > 2 ? (size_t)atol(argv[2]) : 4;
+    size_t max_threads = argc > 3 ? (size_t)atol(argv[3]) : 16;
+
+    srand(42);
+
+    struct StaffKittycatPermissions **sp = malloc(users * sizeof(struct StaffKittycatPermissions *));
+    for (size_t i = 0; i < users; i++)
+    {
+        sp[i] = kittycat_staff_permissions_new();
+        for (size_t j = 0; j < positions_per_user; j++)
+        {
+            kittycat_partial_staff_position_list_add(sp[i]->user_positions, kittycat_partial_staff_position_new("pos", rand() % 10, random_perms(24)));
+        }
+    }
+
+    struct KittycatPermissionList **expected = malloc(users * sizeof(struct KittycatPermissionList *));
+    struct KittycatPermissionList **out = malloc(users * sizeof(struct KittycatPermissionList *));
+
+    double start = now_ms();
+    for (size_t i = 0; i < users; i++)
+    {
+        expected[i] = kittycat_staff_permissions_resolve(sp[i]);
+    }
+    double serial_ms = now_ms() - start;
+
+    printf("%zu users, %zu positions each\n", users, positions_per_user);
+    printf("serial kittycat_staff_permissions_resolve: %8.2f ms\n", serial_ms);
+
+    int rc = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        struct KittycatResolveBatchOptions opts = {threads, KITTYCAT_RESOLVE_FLAGS_NONE};
+
+        start = now_ms();
+        size_t used = kittycat_staff_permissions_resolve_batch((const struct StaffKittycatPermissions *const *)sp, users, out, &opts);
+        double batch_ms = now_ms() - start;
+
+        printf("batch with %2zu threads:                   %8.2f ms (%5.2fx)\n", used, batch_ms, serial_ms / batch_ms);
+
+        for (size_t i = 0; i < users; i++)
+        {
+            if (!kittycat_permission_lists_equal(expected[i], out[i]))
+            {
+                fprintf(stderr, "ERROR: batch result differs from the serial loop for user %zu\n", i);
+                rc = 1;
+                break;
+            }
+        }
+        free_results(out, users);
+    }
+
+    free_results(expected, users);
+    for (size_t i = 0; i < users; i++)
+    {
+        kittycat_staff_permissions_free(sp[i]);
+    }
+    free(sp);
+    free(expected);
+    free(out);
+
+    return rc;
+}
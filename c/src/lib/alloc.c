@@ -2,6 +2,14 @@
 #include "kc_string.h"
 #include "perms.h"
 #include "hashmap.h"
+#include "perm_index.h"
+#include "arena.h"
+#include "position_registry.h"
+#include "resolve_cache.h"
+#include "resolve_tracker.h"
+#include "resolve_batch.h"
+#include "resolver.h"
+#include "patch_checker.h"
 
 void kittycat_set_allocator(
     // Malloc
@@ -17,4 +25,12 @@ void kittycat_set_allocator(
     kittycat_hashmap_set_allocator(malloc, realloc, free);
     kittycat_kc_string_set_allocator(malloc, realloc, free, memcpy);
     kittycat_perms_set_allocator(malloc, realloc, free);
+    kittycat_perm_index_set_allocator(malloc, realloc, free);
+    kittycat_arena_set_allocator(malloc, realloc, free);
+    kittycat_position_registry_set_allocator(malloc, realloc, free);
+    kittycat_resolve_cache_set_allocator(malloc, realloc, free);
+    kittycat_resolve_tracker_set_allocator(malloc, realloc, free);
+    kittycat_resolve_batch_set_allocator(malloc, realloc, free);
+    kittycat_resolver_set_allocator(malloc, realloc, free);
+    kittycat_patch_checker_set_allocator(malloc, realloc, free);
 }
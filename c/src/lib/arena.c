@@ -0,0 +1,150 @@
+#include "arena.h"
+#include <string.h>
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_arena_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+#define __KITTYCAT_ARENA_DEFAULT_CHUNK_SIZE (16 * 1024)
+
+// Every allocation is aligned to and prefixed by a header of this size holding the allocation size
+#define __KITTYCAT_ARENA_ALIGN 16
+
+struct __KittycatArenaChunk
+{
+    struct __KittycatArenaChunk *next;
+    size_t cap;
+    size_t len;
+    // Padding to keep data aligned
+    size_t __pad;
+};
+
+size_t __kittycat_arena_align(size_t size)
+{
+    return (size + __KITTYCAT_ARENA_ALIGN - 1) & ~(size_t)(__KITTYCAT_ARENA_ALIGN - 1);
+}
+
+char *__kittycat_arena_chunk_data(struct __KittycatArenaChunk *chunk)
+{
+    return (char *)chunk + __kittycat_arena_align(sizeof(struct __KittycatArenaChunk));
+}
+
+struct __KittycatArenaChunk *__kittycat_arena_chunk_new(size_t cap)
+{
+    struct __KittycatArenaChunk *chunk = __kittycat_malloc(__kittycat_arena_align(sizeof(struct __KittycatArenaChunk)) + cap);
+    chunk->next = NULL;
+    chunk->cap = cap;
+    chunk->len = 0;
+    return chunk;
+}
+
+struct kittycat_arena *kittycat_arena_new(const size_t chunk_size)
+{
+    struct kittycat_arena *arena = __kittycat_malloc(sizeof(struct kittycat_arena));
+    arena->used = 0;
+    arena->__chunk_size = __kittycat_arena_align(chunk_size > 0 ? chunk_size : __KITTYCAT_ARENA_DEFAULT_CHUNK_SIZE);
+    arena->__head = __kittycat_arena_chunk_new(arena->__chunk_size);
+    return arena;
+}
+
+void *kittycat_arena_alloc(struct kittycat_arena *arena, const size_t size)
+{
+    size_t needed = __KITTYCAT_ARENA_ALIGN + __kittycat_arena_align(size);
+    struct __KittycatArenaChunk *chunk = arena->__head;
+
+    if (chunk->cap - chunk->len < needed)
+    {
+        // Oversized allocations get a chunk of their own
+        chunk = __kittycat_arena_chunk_new(needed > arena->__chunk_size ? needed : arena->__chunk_size);
+        chunk->next = arena->__head;
+        arena->__head = chunk;
+    }
+
+    char *header = __kittycat_arena_chunk_data(chunk) + chunk->len;
+    *(size_t *)header = size;
+    chunk->len += needed;
+    arena->used += needed;
+
+    return header + __KITTYCAT_ARENA_ALIGN;
+}
+
+void *kittycat_arena_realloc(struct kittycat_arena *arena, void *ptr, const size_t size)
+{
+    if (ptr == NULL)
+    {
+        return kittycat_arena_alloc(arena, size);
+    }
+
+    char *header = (char *)ptr - __KITTYCAT_ARENA_ALIGN;
+    size_t old_size = *(size_t *)header;
+    struct __KittycatArenaChunk *chunk = arena->__head;
+    char *chunk_end = __kittycat_arena_chunk_data(chunk) + chunk->len;
+
+    // Grow or shrink the last allocation in place
+    if ((char *)ptr + __kittycat_arena_align(old_size) == chunk_end)
+    {
+        size_t old_aligned = __kittycat_arena_align(old_size);
+        size_t new_aligned = __kittycat_arena_align(size);
+        if (new_aligned <= old_aligned || new_aligned - old_aligned <= chunk->cap - chunk->len)
+        {
+            chunk->len = chunk->len - old_aligned + new_aligned;
+            arena->used = arena->used - old_aligned + new_aligned;
+            *(size_t *)header = size;
+            return ptr;
+        }
+    }
+
+    if (size <= old_size)
+    {
+        *(size_t *)header = size;
+        return ptr;
+    }
+
+    void *new_ptr = kittycat_arena_alloc(arena, size);
+    memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+}
+
+void kittycat_arena_reset(struct kittycat_arena *arena)
+{
+    // Keep the oldest chunk (the one created with the arena), which is always of the default chunk size
+    struct __KittycatArenaChunk *chunk = arena->__head;
+    while (chunk->next != NULL)
+    {
+        struct __KittycatArenaChunk *next = chunk->next;
+        __kittycat_free(chunk);
+        chunk = next;
+    }
+
+    chunk->len = 0;
+    arena->__head = chunk;
+    arena->used = 0;
+}
+
+void kittycat_arena_free(struct kittycat_arena *arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    struct __KittycatArenaChunk *chunk = arena->__head;
+    while (chunk != NULL)
+    {
+        struct __KittycatArenaChunk *next = chunk->next;
+        __kittycat_free(chunk);
+        chunk = next;
+    }
+
+    __kittycat_free(arena);
+}
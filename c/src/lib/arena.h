@@ -0,0 +1,59 @@
+#ifndef KITTYCAT_ARENA_H
+#define KITTYCAT_ARENA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator the kittycat arena code obtains its chunks from
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_arena_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // A bump allocator for scoping kittycat objects to e.g. a single request
+    //
+    // Objects created through the `_in_arena` variants of the kittycat constructors are carved out of large chunks and are
+    // never freed individually: their free functions are no-ops and everything is released at once by `kittycat_arena_reset`
+    // or `kittycat_arena_free`. An arena is not thread-safe
+    struct kittycat_arena
+    {
+        // Total bytes handed out since the last reset
+        size_t used;
+
+        // Internal
+        struct __KittycatArenaChunk *__head;
+        size_t __chunk_size;
+    };
+
+    // Creates a new kittycat_arena allocating chunks of at least `chunk_size` bytes (0 uses a default of 16 KiB)
+    struct kittycat_arena *kittycat_arena_new(const size_t chunk_size);
+
+    // Allocates `size` bytes from the arena. The returned memory is aligned for any kittycat object
+    void *kittycat_arena_alloc(struct kittycat_arena *arena, const size_t size);
+
+    // Resizes an allocation made by `kittycat_arena_alloc`. Like realloc, `ptr` may be NULL
+    //
+    // The last allocation is grown in place when possible, otherwise the data is copied to a new allocation
+    void *kittycat_arena_realloc(struct kittycat_arena *arena, void *ptr, const size_t size);
+
+    // Releases every allocation made from the arena at once
+    //
+    // The first chunk is kept around so that an arena reused for many requests does not need to allocate again
+    void kittycat_arena_reset(struct kittycat_arena *arena);
+
+    // Frees the arena and every allocation made from it
+    void kittycat_arena_free(struct kittycat_arena *arena);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_ARENA_H
@@ -0,0 +1,128 @@
+#ifndef KITTYCAT_INTERNAL_H
+#define KITTYCAT_INTERNAL_H
+
+// Internal helpers shared between the kittycat translation units
+//
+// Note that this header is not installed and has ZERO API stability guarantees
+
+#include "perms.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Creates a new KittycatPermission pointing to the interned strings of the given atoms
+    struct KittycatPermission *__kittycat_new_permission_from_atoms(uint32_t namespace_atom, uint32_t perm_atom, bool negator);
+
+    // Same as `__kittycat_new_permission_from_atoms` but allocates in `arena` unless it is NULL
+    struct KittycatPermission *__kittycat_new_permission_from_atoms_in_arena(struct kittycat_arena *arena, uint32_t namespace_atom, uint32_t perm_atom, bool negator);
+
+    // Splits the canonical representation of a permission in place without copying
+    //
+    // `ns` and `perm` are set to point into `str`. If `str` has no namespace, `ns` is set to NULL and the namespace is global
+    void __kittycat_permission_split(const char *str, size_t len, const char **ns, size_t *ns_len, const char **perm, size_t *perm_len, bool *negator);
+
+// Classification of a KittycatPermission as seen by the resolve engines
+#define __KITTYCAT_ENTRY_NEGATOR 1
+// `ns.@clear` (negated or not)
+#define __KITTYCAT_ENTRY_CLEAR 2
+// A non-negated `ns.*`
+#define __KITTYCAT_ENTRY_WILDCARD 4
+// `global.@clear`. Always set along with __KITTYCAT_ENTRY_CLEAR
+#define __KITTYCAT_ENTRY_GLOBAL_CLEAR 8
+
+    // Returns the __KITTYCAT_ENTRY_* flags of a KittycatPermission
+    uint8_t __kittycat_permission_classify(const struct KittycatPermission *const p);
+
+    // Stably sorts `n` positions by index in descending order, which is the order they are applied in. `tmp` must have room for `n` positions
+    void __kittycat_partial_staff_positions_sort(struct KittycatPartialStaffPosition **positions, struct KittycatPartialStaffPosition **tmp, size_t n);
+
+    // The insertion ordered KittycatPermission map of the forward resolve engine
+    struct __KittycatOrderedPermissionMap;
+
+    // Resolves the KittycatPermissions of a staff member, allocating the result in `arena` unless it is NULL
+    //
+    // Scratch space that does not outlive the call is allocated in `scratch`, or in `arena` if `scratch` is NULL. The forward engine reuses
+    // the empty map `opm` (see `__kittycat_staff_permissions_resolve_forward_with`) unless it is NULL, in which case it uses a fresh one
+    struct KittycatPermissionList *__kittycat_staff_permissions_resolve(const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena, struct kittycat_arena *scratch, struct __KittycatOrderedPermissionMap *opm, const uint32_t flags);
+
+    // Returns the pseudo-position applying the perm overrides of `sp`, between the positions with an index >= 0 and those below 0. It
+    // borrows `sp->perm_overrides` and must be kept alive as long as the positions ordered with it
+    struct KittycatPartialStaffPosition __kittycat_perm_overrides_position(const struct StaffKittycatPermissions *const sp);
+
+    // Fills `out` with the positions of `sp` (plus the perm overrides in `permOverridesPos`) in the order they must be applied in
+    //
+    // `out->positions` is allocated in `arena` unless it is NULL, in which case the caller must free it
+    void __kittycat_staff_permissions_order_positions(const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena, const uint32_t flags, struct KittycatPartialStaffPosition *permOverridesPos, struct KittycatPartialStaffPositionList *out);
+
+    // Same as `__kittycat_staff_permissions_order_positions` but uses `positions`, which must have room for 2 * (`sp->user_positions->len` + 1)
+    // positions, instead of allocating
+    void __kittycat_staff_permissions_order_positions_into(const struct StaffKittycatPermissions *const sp, const uint32_t flags, struct KittycatPartialStaffPosition *permOverridesPos, struct KittycatPartialStaffPosition **positions, struct KittycatPartialStaffPositionList *out);
+
+    struct __KittycatOrderedPermissionMap *__kittycat_ordered_permission_map_new();
+    void __kittycat_ordered_permission_map_free(struct __KittycatOrderedPermissionMap *opm);
+
+    // Resolves ordered positions with the forward engine using the empty map `opm`, which is left empty (but keeps its capacity) afterwards
+    struct KittycatPermissionList *__kittycat_staff_permissions_resolve_forward_with(struct __KittycatOrderedPermissionMap *opm, const struct KittycatPartialStaffPositionList *const userPositions, struct kittycat_arena *arena);
+
+    // Same as `__kittycat_staff_permissions_resolve_forward_with` but compiles the result straight into a KittycatPermissionSet
+    struct KittycatPermissionSet *__kittycat_staff_permissions_resolve_set_with(struct __KittycatOrderedPermissionMap *opm, const struct KittycatPartialStaffPositionList *const userPositions);
+
+    // Creates an empty KittycatPermissionSet with room for `len` permissions
+    struct KittycatPermissionSet *__kittycat_permission_set_new(size_t len);
+
+    // Adds a packed permission (negator bit included) to a KittycatPermissionSet created with `__kittycat_permission_set_new`
+    void __kittycat_permission_set_insert(struct KittycatPermissionSet *set, uint64_t perm);
+
+// The append time of the permission at `perm` in the ordered position at `position`. Unlike a running counter, this stays the same for
+// entries of other positions when a position changes
+#define __KITTYCAT_RESOLVED_TS(position, perm) ((((uint64_t)(position)) << 32) | (uint64_t)(uint32_t)(perm))
+
+    // A resolved permission (negator bit included) along with the time it was appended in the forward engine
+    struct __KittycatResolvedEntry
+    {
+        uint64_t packed;
+        uint64_t ts;
+    };
+
+    // Resolves ordered positions into `len` entries ordered by append time, optionally only for the sorted `namespaces`
+    //
+    // The result must be freed by the caller
+    struct __KittycatResolvedEntry *__kittycat_staff_permissions_resolve_entries(const struct KittycatPartialStaffPositionList *const userPositions, const uint32_t *const namespaces, const size_t nNamespaces, size_t *len);
+
+    // (Re)parses the permissions of a registered position into `pos->perms` and `pos->__kinds`, which must not hold anything
+    void __kittycat_position_registry_parse(struct KittycatPartialStaffPosition *pos, const char *const *perms, const size_t *perm_lens, const size_t len);
+
+    // qsort comparator of __KittycatResolvedEntry by append time
+    int __kittycat_resolved_entry_ts_compare(const void *a, const void *b);
+
+    // qsort comparator of uint32_t atoms
+    int __kittycat_atom_compare(const void *a, const void *b);
+
+    // qsort comparator of packed KittycatPermissions
+    int __kittycat_packed_permission_compare(const void *a, const void *b);
+
+    // The core of `kittycat_has_perm` over a contiguous array of packed permissions
+    bool __kittycat_has_perm_packed(const uint64_t *const perms, const size_t len, const uint32_t namespace_atom, const uint32_t perm_atom);
+
+    // Returns a KittycatPermission that is only used to look up `namespace_atom.perm_atom` and therefore lives on the stack
+    struct KittycatPermission __kittycat_permission_probe(uint32_t namespace_atom, uint32_t perm_atom, bool negator);
+
+    struct kittycat_patch_checker;
+
+    // Checks a patch like `kittycat_patch_checker_check`, against `checker` or, if `checker` is NULL, straight against `manager_perms`
+    struct KittycatPermissionCheckPatchChangesResult __kittycat_patch_check(
+        const struct kittycat_patch_checker *const checker,
+        const struct KittycatPermissionList *const manager_perms,
+        const struct KittycatPermissionList *const current_perms,
+        const struct KittycatPermissionList *const new_perms);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_INTERNAL_H
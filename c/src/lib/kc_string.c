@@ -1,4 +1,7 @@
 #include "kc_string.h"
+#include "hashmap.h"
+#include "arena.h"
+#include <pthread.h>
 
 static void *(*__kittycat_malloc)(size_t) = NULL;
 static void *(*__kittycat_realloc)(void *, size_t) = NULL;
@@ -27,6 +30,17 @@ struct kittycat_string *kittycat_string_new(char *str, const size_t len)
     s->str = str;
     s->len = len;
     s->__isCloned = false;
+    s->__arena = NULL;
+    return s;
+}
+
+struct kittycat_string *kittycat_string_new_in_arena(struct kittycat_arena *arena, char *str, const size_t len)
+{
+    struct kittycat_string *s = kittycat_arena_alloc(arena, sizeof(struct kittycat_string));
+    s->str = str;
+    s->len = len;
+    s->__isCloned = false;
+    s->__arena = arena;
     return s;
 }
 
@@ -62,6 +76,17 @@ struct kittycat_string *kittycat_string_clone_from_chararr(const char *const str
     s->str = cp_str;
     s->len = len;
     s->__isCloned = true;
+    s->__arena = NULL;
+    return s;
+}
+
+struct kittycat_string *kittycat_string_clone_from_chararr_in_arena(struct kittycat_arena *arena, const char *const str, const size_t len)
+{
+    char *cp_str = kittycat_arena_alloc(arena, len + 1);
+    __kittycat_memcpy(cp_str, str, len);
+    cp_str[len] = '\0';
+    struct kittycat_string *s = kittycat_string_new_in_arena(arena, cp_str, len);
+    s->__isCloned = true;
     return s;
 }
 
@@ -124,6 +149,9 @@ void kittycat_string_free(struct kittycat_string *s)
     // Already freed if NULL
     if (!s)
         return;
+    // Strings allocated in an arena are released together with the arena
+    if (s->__arena != NULL)
+        return;
     if (s->__isCloned)
     {
         __kittycat_free(s->str); // Free the string
@@ -153,7 +181,12 @@ bool kittycat_string_equal(const struct kittycat_string *const s1, const struct
         return false;
     }
 
-    return strcmp(s1->str, s2->str) == 0;
+    return memcmp(s1->str, s2->str, s1->len) == 0;
+}
+
+bool kittycat_string_view_equal(const struct kittycat_string_view v1, const struct kittycat_string_view v2)
+{
+    return v1.len == v2.len && memcmp(v1.str, v2.str, v1.len) == 0;
 }
 
 bool kittycat_string_contains(const struct kittycat_string *const s, const char c)
@@ -182,4 +215,218 @@ struct kittycat_string *kittycat_string_trim_prefix(const struct kittycat_string
     }
 
     return kittycat_string_substr(s, start, s->len);
-}
\ No newline at end of file
+}
+/* String interning */
+
+// An entry in the interner's lookup table
+//
+// `str` always points into the interned copy owned by `__kittycat_atoms`, except for probes built by lookups
+struct __KittycatAtomEntry
+{
+    const char *str;
+    size_t len;
+    uint32_t atom;
+};
+
+static struct kittycat_string __kittycat_reserved_atoms[] = {
+    {"", 0, false, NULL},       // KITTYCAT_ATOM_NONE
+    {"global", 6, false, NULL}, // KITTYCAT_ATOM_GLOBAL
+    {"*", 1, false, NULL},      // KITTYCAT_ATOM_WILDCARD
+    {"@clear", 6, false, NULL}, // KITTYCAT_ATOM_CLEAR
+};
+
+#define __KITTYCAT_RESERVED_ATOMS_LEN (sizeof(__kittycat_reserved_atoms) / sizeof(__kittycat_reserved_atoms[0]))
+
+// The interner is shared by every thread. Interning and lookups take `__kittycat_atoms_lock`, while `kittycat_string_atom_str`
+// (used by the resolve engines on every thread of a batch resolve) reads `__kittycat_atoms` without locking. For this, the atom
+// array is never freed while growing: the old array is retired and kept around, so a reader still holding it sees valid atoms.
+//
+// Writers publish a grown array before the length that needs it, both with release stores, and readers load the length before the
+// array, both with acquire loads. A reader seeing a length therefore also sees an array (the same or a later copy) holding that many atoms
+static pthread_mutex_t __kittycat_atoms_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct kittycat_hashmap *__kittycat_atom_map = NULL;
+static struct kittycat_string **__kittycat_atoms = NULL;
+static size_t __kittycat_atoms_len = 0;
+static size_t __kittycat_atoms_cap = 0;
+// Atom arrays replaced while growing, each storing the previously retired array in its first slot
+static struct kittycat_string **__kittycat_atoms_retired = NULL;
+
+uint64_t __kittycat_atom_entry_hash(const void *item, uint64_t seed0, uint64_t seed1)
+{
+    const struct __KittycatAtomEntry *e = item;
+    return kittycat_hashmap_xxhash3(e->str, e->len, seed0, seed1);
+}
+
+int __kittycat_atom_entry_compare(const void *a, const void *b, void *udata)
+{
+    const struct __KittycatAtomEntry *ea = a;
+    const struct __KittycatAtomEntry *eb = b;
+
+    if (ea->len != eb->len)
+    {
+        return 1;
+    }
+
+    return memcmp(ea->str, eb->str, ea->len);
+}
+
+void __kittycat_atom_push(struct kittycat_string *s)
+{
+    if (__kittycat_atoms_len == __kittycat_atoms_cap)
+    {
+        size_t cap = __kittycat_atoms_cap ? __kittycat_atoms_cap * 2 : 64;
+        struct kittycat_string **atoms = __kittycat_malloc(cap * sizeof(struct kittycat_string *));
+        if (__kittycat_atoms != NULL)
+        {
+            __kittycat_memcpy(atoms, __kittycat_atoms, __kittycat_atoms_len * sizeof(struct kittycat_string *));
+            __kittycat_atoms[0] = (struct kittycat_string *)__kittycat_atoms_retired;
+            __kittycat_atoms_retired = __kittycat_atoms;
+        }
+        __atomic_store_n(&__kittycat_atoms, atoms, __ATOMIC_RELEASE);
+        __kittycat_atoms_cap = cap;
+    }
+
+    struct __KittycatAtomEntry e = {s->str, s->len, (uint32_t)__kittycat_atoms_len};
+    __kittycat_atoms[__kittycat_atoms_len] = s;
+    __atomic_store_n(&__kittycat_atoms_len, __kittycat_atoms_len + 1, __ATOMIC_RELEASE);
+
+    kittycat_hashmap_set(__kittycat_atom_map, &e);
+}
+
+void __kittycat_interner_init()
+{
+    __kittycat_atom_map = kittycat_hashmap_new(sizeof(struct __KittycatAtomEntry), 0, 0, 0, __kittycat_atom_entry_hash, __kittycat_atom_entry_compare, NULL, NULL);
+
+    for (size_t i = 0; i < __KITTYCAT_RESERVED_ATOMS_LEN; i++)
+    {
+        __kittycat_atom_push(&__kittycat_reserved_atoms[i]);
+    }
+
+    // The empty string is a perfectly valid (if odd) namespace or perm, so KITTYCAT_ATOM_NONE
+    // must never be found through a lookup
+    struct __KittycatAtomEntry none = {"", 0, KITTYCAT_ATOM_NONE};
+    kittycat_hashmap_delete(__kittycat_atom_map, &none);
+}
+
+uint32_t kittycat_string_intern(const char *const str, const size_t len)
+{
+    pthread_mutex_lock(&__kittycat_atoms_lock);
+
+    if (__kittycat_atom_map == NULL)
+    {
+        __kittycat_interner_init();
+    }
+
+    struct __KittycatAtomEntry probe = {str, len, KITTYCAT_ATOM_NONE};
+    const struct __KittycatAtomEntry *found = kittycat_hashmap_get(__kittycat_atom_map, &probe);
+    if (found != NULL)
+    {
+        uint32_t atom = found->atom;
+        pthread_mutex_unlock(&__kittycat_atoms_lock);
+        return atom;
+    }
+
+    // Copy the string. We can't use __kittycat_strndup here as `str` is not necessarily NUL terminated
+    char *cp_str = __kittycat_malloc(len + 1);
+    __kittycat_memcpy(cp_str, str, len);
+    cp_str[len] = '\0';
+
+    struct kittycat_string *s = kittycat_string_new(cp_str, len);
+    s->__isCloned = true;
+
+    __kittycat_atom_push(s);
+    uint32_t atom = (uint32_t)(__kittycat_atoms_len - 1);
+
+    pthread_mutex_unlock(&__kittycat_atoms_lock);
+    return atom;
+}
+
+uint32_t kittycat_string_intern_str(const struct kittycat_string *const s)
+{
+    return kittycat_string_intern(s->str, s->len);
+}
+
+uint32_t kittycat_string_atom_lookup(const char *const str, const size_t len)
+{
+    pthread_mutex_lock(&__kittycat_atoms_lock);
+
+    if (__kittycat_atom_map == NULL)
+    {
+        pthread_mutex_unlock(&__kittycat_atoms_lock);
+
+        // Only the reserved atoms can exist at this point
+        for (size_t i = 1; i < __KITTYCAT_RESERVED_ATOMS_LEN; i++)
+        {
+            if (__kittycat_reserved_atoms[i].len == len && memcmp(__kittycat_reserved_atoms[i].str, str, len) == 0)
+            {
+                return (uint32_t)i;
+            }
+        }
+
+        return KITTYCAT_ATOM_NONE;
+    }
+
+    struct __KittycatAtomEntry probe = {str, len, KITTYCAT_ATOM_NONE};
+    const struct __KittycatAtomEntry *found = kittycat_hashmap_get(__kittycat_atom_map, &probe);
+    uint32_t atom = found == NULL ? KITTYCAT_ATOM_NONE : found->atom;
+
+    pthread_mutex_unlock(&__kittycat_atoms_lock);
+    return atom;
+}
+
+struct kittycat_string *kittycat_string_atom_str(const uint32_t atom)
+{
+    if (atom == KITTYCAT_ATOM_NONE)
+    {
+        return NULL;
+    }
+
+    // The length is 0 until the interner has been used for the first time
+    size_t len = __atomic_load_n(&__kittycat_atoms_len, __ATOMIC_ACQUIRE);
+    if (len == 0)
+    {
+        return atom < __KITTYCAT_RESERVED_ATOMS_LEN ? &__kittycat_reserved_atoms[atom] : NULL;
+    }
+
+    return atom < len ? __atomic_load_n(&__kittycat_atoms, __ATOMIC_ACQUIRE)[atom] : NULL;
+}
+
+size_t kittycat_string_interner_len()
+{
+    size_t len = __atomic_load_n(&__kittycat_atoms_len, __ATOMIC_ACQUIRE);
+    return len == 0 ? __KITTYCAT_RESERVED_ATOMS_LEN : len;
+}
+
+void kittycat_string_interner_free()
+{
+    pthread_mutex_lock(&__kittycat_atoms_lock);
+
+    if (__kittycat_atom_map == NULL)
+    {
+        pthread_mutex_unlock(&__kittycat_atoms_lock);
+        return;
+    }
+
+    // Reserved atoms are static and must not be freed
+    for (size_t i = __KITTYCAT_RESERVED_ATOMS_LEN; i < __kittycat_atoms_len; i++)
+    {
+        kittycat_string_free(__kittycat_atoms[i]);
+    }
+
+    while (__kittycat_atoms_retired != NULL)
+    {
+        struct kittycat_string **next = (struct kittycat_string **)__kittycat_atoms_retired[0];
+        __kittycat_free(__kittycat_atoms_retired);
+        __kittycat_atoms_retired = next;
+    }
+
+    __kittycat_free(__kittycat_atoms);
+    kittycat_hashmap_free(__kittycat_atom_map);
+
+    __atomic_store_n(&__kittycat_atoms_len, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&__kittycat_atoms, NULL, __ATOMIC_RELEASE);
+    __kittycat_atoms_cap = 0;
+    __kittycat_atom_map = NULL;
+
+    pthread_mutex_unlock(&__kittycat_atoms_lock);
+}
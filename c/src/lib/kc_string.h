@@ -6,6 +6,7 @@
 #include <unistd.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 
 #if defined(__cplusplus)
 extern "C"
@@ -21,6 +22,9 @@ extern "C"
         void (*free)(void *),
         void *(*memcpy)(void *, const void *, size_t));
 
+    // Defined in arena.h
+    struct kittycat_arena;
+
     // String
     struct kittycat_string
     {
@@ -29,8 +33,22 @@ extern "C"
 
         // Internal
         bool __isCloned;
+        // The arena the string was allocated in, if any (see `kittycat_string_new_in_arena`)
+        struct kittycat_arena *__arena;
     };
 
+    // A borrowed, read only view into a string
+    //
+    // Unlike a kittycat_string, a view never owns the memory it points to, is never heap allocated and does not need to be NUL terminated
+    struct kittycat_string_view
+    {
+        const char *str;
+        size_t len;
+    };
+
+    // Returns if two string views are equal
+    bool kittycat_string_view_equal(const struct kittycat_string_view v1, const struct kittycat_string_view v2);
+
     // String functions
 
     // Create a new string
@@ -45,6 +63,16 @@ extern "C"
     // When `kittycat_string_free` is called, the underlying char array will also be freed
     struct kittycat_string *kittycat_string_clone_from_chararr(const char *const str, const size_t len);
 
+    // Same as `kittycat_string_new` but allocates the string in `arena`
+    //
+    // The string is released when the arena is reset or freed, calling `kittycat_string_free` on it is a no-op
+    struct kittycat_string *kittycat_string_new_in_arena(struct kittycat_arena *arena, char *str, const size_t len);
+
+    // Same as `kittycat_string_clone_from_chararr` but allocates both the string and its copied char array in `arena`
+    //
+    // The string is released when the arena is reset or freed, calling `kittycat_string_free` on it is a no-op
+    struct kittycat_string *kittycat_string_clone_from_chararr_in_arena(struct kittycat_arena *arena, const char *const str, const size_t len);
+
     // Helper function. Equivalent to calling `kittycat_string_clone_from_chararr(s->str, s->len)`
     struct kittycat_string *kittycat_string_clone(const struct kittycat_string *const s);
 
@@ -70,7 +98,7 @@ extern "C"
     // Returns if a string `s` is empty or not
     bool kittycat_string_empty(const struct kittycat_string *const s);
 
-    // Returns if two strings are equal or not
+    // Returns if two strings are equal or not. The strings do not need to be NUL terminated
     bool kittycat_string_equal(const struct kittycat_string *const s1, const struct kittycat_string *const s2);
 
     // Returns if a string `s` contains a character `c`
@@ -84,6 +112,52 @@ extern "C"
     // EX: `kittycat_string_trim_prefix("aabc", 'a')` will return "bc"
     struct kittycat_string *kittycat_string_trim_prefix(const struct kittycat_string *const s, const char c);
 
+    // String interning
+    //
+    // The interner maps each distinct string to a stable 32-bit atom. Two strings are equal if and only if
+    // their atoms are equal, and every user of an atom shares the single copy of the string owned by the interner.
+    //
+    // Atom 0 is never handed out and means "not interned". The first few atoms are reserved for the
+    // strings kittycat permission handling needs to special-case and are always available, even before
+    // the interner has been used for the first time.
+#define KITTYCAT_ATOM_NONE 0
+#define KITTYCAT_ATOM_GLOBAL 1   // "global"
+#define KITTYCAT_ATOM_WILDCARD 2 // "*"
+#define KITTYCAT_ATOM_CLEAR 3    // "@clear"
+
+    // Interns the `len` bytes at `str` (which do not need to be NUL terminated), returning its atom
+    //
+    // The string is copied on first use. Subsequent calls with an equal string return the same atom
+    uint32_t kittycat_string_intern(const char *const str, const size_t len);
+
+    // Helper function. Equivalent to calling `kittycat_string_intern(s->str, s->len)`
+    uint32_t kittycat_string_intern_str(const struct kittycat_string *const s);
+
+    // Returns the atom of the `len` bytes at `str` if they have already been interned, or `KITTYCAT_ATOM_NONE` otherwise
+    //
+    // Unlike `kittycat_string_intern`, this never allocates
+    uint32_t kittycat_string_atom_lookup(const char *const str, const size_t len);
+
+    // Returns the interned string for an atom, or NULL if the atom is unknown
+    //
+    // Note: the returned string is owned by the interner and must *not* be freed by the caller.
+    // It stays valid until `kittycat_string_interner_free` is called
+    //
+    // This never locks and may run while other threads intern new strings (e.g. during a batch resolve). Every atom interned before the
+    // caller got hold of `atom` (through the KittycatPermission holding it, or any other synchronization with the interning thread) is found
+    struct kittycat_string *kittycat_string_atom_str(const uint32_t atom);
+
+    // Returns the number of atoms currently held by the interner (including the reserved atoms)
+    //
+    // Like `kittycat_string_atom_str`, this never locks. While other threads intern, it returns a snapshot: every atom below it is valid
+    size_t kittycat_string_interner_len();
+
+    // Frees every interned string
+    //
+    // Note: any atom or interned string obtained before this call is invalidated. This is mostly useful
+    // for leak checkers and tests, long running processes should just keep the interner around
+    void kittycat_string_interner_free();
+
 #if defined(__cplusplus)
 }
 #endif // __cplusplus
@@ -0,0 +1,433 @@
+// sysconf(_SC_NPROCESSORS_ONLN) and pthreads are POSIX, which strict C99 builds hide unless asked for
+#define _POSIX_C_SOURCE 200809L
+
+#include "patch_checker.h"
+#include "internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_patch_checker_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+// Sorts the packed forms of `pl` into `out`, dropping duplicates. Returns the number of distinct KittycatPermissions
+size_t __kittycat_permission_list_pack_sorted(const struct KittycatPermissionList *const pl, uint64_t *out)
+{
+    for (size_t i = 0; i < pl->len; i++)
+    {
+        out[i] = KITTYCAT_PACKED_PERMISSION(pl->perms[i]->namespace_atom, pl->perms[i]->perm_atom, pl->perms[i]->negator);
+    }
+    qsort(out, pl->len, sizeof(uint64_t), __kittycat_packed_permission_compare);
+
+    size_t len = 0;
+    for (size_t i = 0; i < pl->len; i++)
+    {
+        if (len == 0 || out[len - 1] != out[i])
+        {
+            out[len++] = out[i];
+        }
+    }
+    return len;
+}
+
+// A distinct negator of a manager along with the index of its first occurrence in the manager's KittycatPermissions
+struct __KittycatPatchNegator
+{
+    uint64_t packed;
+    size_t index;
+};
+
+// qsort comparator of __KittycatPatchNegator by packed permission, then by index
+int __kittycat_patch_negator_compare(const void *a, const void *b)
+{
+    const struct __KittycatPatchNegator *na = a;
+    const struct __KittycatPatchNegator *nb = b;
+    if (na->packed != nb->packed)
+    {
+        return na->packed < nb->packed ? -1 : 1;
+    }
+    return na->index < nb->index ? -1 : (na->index > nb->index ? 1 : 0);
+}
+
+// qsort comparator of __KittycatPatchNegator by namespace, then by index
+int __kittycat_patch_negator_order_compare(const void *a, const void *b)
+{
+    const struct __KittycatPatchNegator *na = a;
+    const struct __KittycatPatchNegator *nb = b;
+    uint32_t nsa = KITTYCAT_PACKED_PERMISSION_NAMESPACE(na->packed);
+    uint32_t nsb = KITTYCAT_PACKED_PERMISSION_NAMESPACE(nb->packed);
+    if (nsa != nsb)
+    {
+        return nsa < nsb ? -1 : 1;
+    }
+    return na->index < nb->index ? -1 : (na->index > nb->index ? 1 : 0);
+}
+
+struct kittycat_patch_checker *kittycat_patch_checker_new(const struct KittycatPermissionList *const manager_perms)
+{
+    struct kittycat_patch_checker *checker = __kittycat_malloc(sizeof(struct kittycat_patch_checker));
+    checker->__set = kittycat_permission_set_compile(manager_perms);
+
+    struct __KittycatPatchNegator *negators = __kittycat_malloc((manager_perms->len + 1) * sizeof(struct __KittycatPatchNegator));
+    size_t n = 0;
+    for (size_t i = 0; i < manager_perms->len; i++)
+    {
+        struct KittycatPermission *p = manager_perms->perms[i];
+        if (p->negator)
+        {
+            negators[n++] = (struct __KittycatPatchNegator){KITTYCAT_PACKED_PERMISSION(p->namespace_atom, p->perm_atom, true), i};
+        }
+    }
+
+    // Drop duplicates, keeping the first occurrence of each negator
+    qsort(negators, n, sizeof(struct __KittycatPatchNegator), __kittycat_patch_negator_compare);
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (len == 0 || negators[len - 1].packed != negators[i].packed)
+        {
+            negators[len++] = negators[i];
+        }
+    }
+
+    // kittycat_check_patch_changes checks the negators of a namespace in the order of manager_perms, so the first missing one it reports
+    // depends on that order rather than on the atoms
+    qsort(negators, len, sizeof(struct __KittycatPatchNegator), __kittycat_patch_negator_order_compare);
+    checker->__negators = __kittycat_malloc((len + 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < len; i++)
+    {
+        checker->__negators[i] = negators[i].packed;
+    }
+    checker->__negators_len = len;
+    __kittycat_free(negators);
+
+    return checker;
+}
+
+// Returns the index of the first negator of the checker in `namespace_atom`, or `__negators_len` if there is none
+size_t __kittycat_patch_checker_negators_of(const struct kittycat_patch_checker *const checker, uint32_t namespace_atom)
+{
+    size_t lo = 0, hi = checker->__negators_len;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (KITTYCAT_PACKED_PERMISSION_NAMESPACE(checker->__negators[mid]) < namespace_atom)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Called by `__kittycat_patch_checker_walk` for every failing KittycatPermission. `negator` is the missing negator for
+// KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD and 0 otherwise. Returns whether to keep checking
+typedef bool (*__kittycat_patch_failure_fn)(void *udata, enum KittycatPermissionCheckPatchChangesResultState reason, uint64_t perm, uint64_t negator);
+
+// Checks a patch, reporting its failures to `fail` in the order of the packed changed KittycatPermissions. `scratch` must hold at least
+// `current_perms->len + new_perms->len` packed permissions
+//
+// The manager is `checker`, or the unprepared `manager_perms` if `checker` is NULL. A one-shot check then scans `manager_perms` for each
+// changed KittycatPermission rather than paying for a KittycatPermissionSet it would only use once
+void __kittycat_patch_checker_walk(
+    const struct kittycat_patch_checker *const checker,
+    const struct KittycatPermissionList *const manager_perms,
+    const struct KittycatPermissionList *const current_perms,
+    const struct KittycatPermissionList *const new_perms,
+    uint64_t *scratch,
+    __kittycat_patch_failure_fn fail,
+    void *udata)
+{
+    // The changed KittycatPermissions are the symmetric difference of current_perms and new_perms. Both are sorted by their packed form
+    // and merged in one pass
+    uint64_t *current = scratch;
+    uint64_t *new = scratch + current_perms->len;
+    size_t currentLen = __kittycat_permission_list_pack_sorted(current_perms, current);
+    size_t newLen = __kittycat_permission_list_pack_sorted(new_perms, new);
+
+    size_t i = 0, j = 0;
+    while (i < currentLen || j < newLen)
+    {
+        uint64_t perm;
+        if (j == newLen || (i < currentLen && current[i] < new[j]))
+        {
+            perm = current[i++]; // Removed
+        }
+        else if (i == currentLen || new[j] < current[i])
+        {
+            perm = new[j++]; // Added
+        }
+        else
+        {
+            i++, j++; // Unchanged
+            continue;
+        }
+
+        uint32_t namespaceAtom = KITTYCAT_PACKED_PERMISSION_NAMESPACE(perm);
+        uint32_t permAtom = KITTYCAT_PACKED_PERMISSION_PERM(perm);
+
+        // Check if the manager has the KittycatPermission, with the negator stripped. If not, its negators do not matter
+        bool hasPerm;
+        if (checker != NULL)
+        {
+            hasPerm = kittycat_permission_set_has_packed(checker->__set, KITTYCAT_PACKED_PERMISSION(namespaceAtom, permAtom, false));
+        }
+        else
+        {
+            struct KittycatPermission resolvedPerm = __kittycat_permission_probe(namespaceAtom, permAtom, false);
+            hasPerm = kittycat_has_perm(manager_perms, &resolvedPerm);
+        }
+
+        if (!hasPerm)
+        {
+            if (!fail(udata, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_NO_PERMISSION, perm, 0))
+            {
+                return;
+            }
+            continue;
+        }
+
+        if (permAtom == KITTYCAT_ATOM_WILDCARD && checker == NULL)
+        {
+            // Ensure that new_perms has *at least* negators that manager_perms has within the namespace
+            for (size_t k = 0; k < manager_perms->len; k++)
+            {
+                struct KittycatPermission *negator = manager_perms->perms[k];
+                if (!negator->negator || negator->namespace_atom != namespaceAtom)
+                {
+                    continue;
+                }
+
+                uint64_t packedNegator = KITTYCAT_PACKED_PERMISSION(negator->namespace_atom, negator->perm_atom, true);
+                if (bsearch(&packedNegator, new, newLen, sizeof(uint64_t), __kittycat_packed_permission_compare) == NULL &&
+                    !fail(udata, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD, perm, packedNegator))
+                {
+                    return;
+                }
+            }
+        }
+        else if (permAtom == KITTYCAT_ATOM_WILDCARD)
+        {
+            // Same as above, with the manager's negators looked up by namespace
+            for (size_t k = __kittycat_patch_checker_negators_of(checker, namespaceAtom);
+                 k < checker->__negators_len && KITTYCAT_PACKED_PERMISSION_NAMESPACE(checker->__negators[k]) == namespaceAtom;
+                 k++)
+            {
+                if (bsearch(&checker->__negators[k], new, newLen, sizeof(uint64_t), __kittycat_packed_permission_compare) == NULL &&
+                    !fail(udata, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD, perm, checker->__negators[k]))
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// Keeps the first failure of a patch as a KittycatPermissionCheckPatchChangesResult
+bool __kittycat_patch_checker_first_failure(void *udata, enum KittycatPermissionCheckPatchChangesResultState reason, uint64_t perm, uint64_t negator)
+{
+    struct KittycatPermissionCheckPatchChangesResult *result = udata;
+    result->state = reason;
+    result->failing_perms = kittycat_permission_list_new();
+    kittycat_permission_list_add(result->failing_perms, __kittycat_new_permission_from_atoms(KITTYCAT_PACKED_PERMISSION_NAMESPACE(perm), KITTYCAT_PACKED_PERMISSION_PERM(perm), KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(perm)));
+    if (reason == KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD)
+    {
+        kittycat_permission_list_add(result->failing_perms, __kittycat_new_permission_from_atoms(KITTYCAT_PACKED_PERMISSION_NAMESPACE(negator), KITTYCAT_PACKED_PERMISSION_PERM(negator), true));
+    }
+    return false;
+}
+
+struct KittycatPermissionCheckPatchChangesResult __kittycat_patch_check(
+    const struct kittycat_patch_checker *const checker,
+    const struct KittycatPermissionList *const manager_perms,
+    const struct KittycatPermissionList *const current_perms,
+    const struct KittycatPermissionList *const new_perms)
+{
+    struct KittycatPermissionCheckPatchChangesResult result = {
+        .state = KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK};
+
+    uint64_t *scratch = __kittycat_malloc((current_perms->len + new_perms->len + 1) * sizeof(uint64_t));
+    __kittycat_patch_checker_walk(checker, manager_perms, current_perms, new_perms, scratch, __kittycat_patch_checker_first_failure, &result);
+    __kittycat_free(scratch);
+
+    return result;
+}
+
+struct KittycatPermissionCheckPatchChangesResult kittycat_patch_checker_check(
+    const struct kittycat_patch_checker *const checker,
+    const struct KittycatPermissionList *const current_perms,
+    const struct KittycatPermissionList *const new_perms)
+{
+    return __kittycat_patch_check(checker, NULL, current_perms, new_perms);
+}
+
+// Smallest number of patches worth starting a thread for
+#define __KITTYCAT_PATCH_BATCH_MIN_SHARE 64
+
+// A thread of a batch check, checking patches [begin, end) into its own failure array
+struct __KittycatPatchBatchWorker
+{
+    const struct kittycat_patch_checker *checker;
+    const struct KittycatPermissionList *const *current_perms;
+    const struct KittycatPermissionList *const *new_perms;
+    size_t begin;
+    size_t end;
+    pthread_t thread;
+    bool started;
+
+    // The patch being checked
+    size_t patch;
+    struct KittycatPatchFailure *failures;
+    size_t len;
+    size_t cap;
+};
+
+bool __kittycat_patch_batch_add_failure(void *udata, enum KittycatPermissionCheckPatchChangesResultState reason, uint64_t perm, uint64_t negator)
+{
+    struct __KittycatPatchBatchWorker *w = udata;
+    if (w->len == w->cap)
+    {
+        w->cap = w->cap == 0 ? 16 : w->cap * 2;
+        w->failures = __kittycat_realloc(w->failures, w->cap * sizeof(struct KittycatPatchFailure));
+    }
+
+    w->failures[w->len++] = (struct KittycatPatchFailure){w->patch, reason, perm, negator};
+    return true;
+}
+
+void *__kittycat_patch_batch_worker_run(void *arg)
+{
+    struct __KittycatPatchBatchWorker *w = arg;
+
+    // One scratch buffer for the whole share, grown to the largest patch
+    uint64_t *scratch = NULL;
+    size_t scratchCap = 0;
+    for (w->patch = w->begin; w->patch < w->end; w->patch++)
+    {
+        size_t needed = w->current_perms[w->patch]->len + w->new_perms[w->patch]->len + 1;
+        if (needed > scratchCap)
+        {
+            scratchCap = needed;
+            scratch = __kittycat_realloc(scratch, scratchCap * sizeof(uint64_t));
+        }
+
+        __kittycat_patch_checker_walk(w->checker, NULL, w->current_perms[w->patch], w->new_perms[w->patch], scratch, __kittycat_patch_batch_add_failure, w);
+    }
+
+    if (scratch != NULL)
+    {
+        __kittycat_free(scratch);
+    }
+    return NULL;
+}
+
+struct KittycatPatchCheckBatchResult *kittycat_patch_checker_check_batch(
+    const struct kittycat_patch_checker *const checker,
+    const struct KittycatPermissionList *const *current_perms,
+    const struct KittycatPermissionList *const *new_perms,
+    const size_t n,
+    size_t threads)
+{
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    size_t maxThreads = (n + __KITTYCAT_PATCH_BATCH_MIN_SHARE - 1) / __KITTYCAT_PATCH_BATCH_MIN_SHARE;
+    if (threads > maxThreads)
+    {
+        threads = maxThreads > 0 ? maxThreads : 1;
+    }
+
+    struct __KittycatPatchBatchWorker *workers = __kittycat_malloc(threads * sizeof(struct __KittycatPatchBatchWorker));
+    for (size_t i = 0; i < threads; i++)
+    {
+        workers[i] = (struct __KittycatPatchBatchWorker){
+            .checker = checker,
+            .current_perms = current_perms,
+            .new_perms = new_perms,
+            .begin = n * i / threads,
+            .end = n * (i + 1) / threads,
+        };
+    }
+
+    // The calling thread checks the first share, and any share whose thread cannot be started
+    for (size_t i = 1; i < threads; i++)
+    {
+        workers[i].started = pthread_create(&workers[i].thread, NULL, __kittycat_patch_batch_worker_run, &workers[i]) == 0;
+    }
+    for (size_t i = 0; i < threads; i++)
+    {
+        if (!workers[i].started)
+        {
+            __kittycat_patch_batch_worker_run(&workers[i]);
+        }
+    }
+
+    struct KittycatPatchCheckBatchResult *result = __kittycat_malloc(sizeof(struct KittycatPatchCheckBatchResult));
+    result->len = 0;
+    for (size_t i = 0; i < threads; i++)
+    {
+        if (workers[i].started)
+        {
+            pthread_join(workers[i].thread, NULL);
+        }
+        result->len += workers[i].len;
+    }
+
+    // The shares are in patch order, so concatenating them keeps the failures sorted by patch
+    result->failures = __kittycat_malloc((result->len + 1) * sizeof(struct KittycatPatchFailure));
+    size_t len = 0;
+    for (size_t i = 0; i < threads; i++)
+    {
+        for (size_t k = 0; k < workers[i].len; k++)
+        {
+            result->failures[len++] = workers[i].failures[k];
+        }
+        if (workers[i].failures != NULL)
+        {
+            __kittycat_free(workers[i].failures);
+        }
+    }
+
+    __kittycat_free(workers);
+    return result;
+}
+
+void kittycat_patch_check_batch_result_free(struct KittycatPatchCheckBatchResult *result)
+{
+    if (result == NULL)
+    {
+        return;
+    }
+
+    __kittycat_free(result->failures);
+    __kittycat_free(result);
+}
+
+void kittycat_patch_checker_free(struct kittycat_patch_checker *checker)
+{
+    if (checker == NULL)
+    {
+        return;
+    }
+
+    kittycat_permission_set_free(checker->__set);
+    __kittycat_free(checker->__negators);
+    __kittycat_free(checker);
+}
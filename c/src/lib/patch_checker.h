@@ -0,0 +1,95 @@
+#ifndef KITTYCAT_PATCH_CHECKER_H
+#define KITTYCAT_PATCH_CHECKER_H
+
+#include "perms.h"
+#include "perm_index.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator for the kittycat patch checker
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_patch_checker_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // The resolved KittycatPermissions of a manager, prepared for checking many patches with `kittycat_patch_checker_check`
+    //
+    // `kittycat_check_patch_changes` scans the manager's permissions for every changed KittycatPermission. A kittycat_patch_checker
+    // prepares them once instead: it compiles them into a KittycatPermissionSet and indexes the manager's negators by namespace, so a
+    // check only costs work proportional to the size of the patch. A kittycat_patch_checker is never modified after creation and may be shared between threads
+    struct kittycat_patch_checker
+    {
+        // Internal
+        struct KittycatPermissionSet *__set;
+        // The distinct negators of the manager, packed, sorted by namespace and kept in the order of the manager's KittycatPermissions
+        // within a namespace
+        uint64_t *__negators;
+        size_t __negators_len;
+    };
+
+    // Creates a new kittycat_patch_checker for the resolved KittycatPermissions of a manager
+    //
+    // The checker does not reference `manager_perms` after this call. It must be freed using `kittycat_patch_checker_free`
+    struct kittycat_patch_checker *kittycat_patch_checker_new(const struct KittycatPermissionList *const manager_perms);
+
+    // Checks whether the manager allows changing the KittycatPermissions of a position from `current_perms` to `new_perms`
+    //
+    // This returns exactly what `kittycat_check_patch_changes` returns for the manager's KittycatPermissions
+    struct KittycatPermissionCheckPatchChangesResult kittycat_patch_checker_check(
+        const struct kittycat_patch_checker *const checker,
+        const struct KittycatPermissionList *const current_perms,
+        const struct KittycatPermissionList *const new_perms);
+
+    // A failing KittycatPermission of a patch checked by `kittycat_patch_checker_check_batch`
+    struct KittycatPatchFailure
+    {
+        // Index of the patch in the batch
+        size_t patch;
+        // Why the change is refused. Never KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK
+        enum KittycatPermissionCheckPatchChangesResultState reason;
+        // The changed KittycatPermission, packed (see `KITTYCAT_PACKED_PERMISSION`)
+        uint64_t perm;
+        // The packed negator missing from the new KittycatPermissions for KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD, 0 otherwise
+        uint64_t negator;
+    };
+
+    // Returned by `kittycat_patch_checker_check_batch`
+    struct KittycatPatchCheckBatchResult
+    {
+        // Every failure of the batch, sorted by patch. No failures means every patch is allowed
+        struct KittycatPatchFailure *failures;
+        size_t len;
+    };
+
+    // Checks `n` patches (changing `current_perms[i]` to `new_perms[i]`) at once, reporting every failing KittycatPermission
+    //
+    // Unlike `kittycat_patch_checker_check`, checking a patch does not stop at its first failure. A failing KittycatPermission is reported
+    // once for lacking permission, or once per missing negator for a wildcard. Large batches are split between `threads` threads, 0 using
+    // one per online CPU, in which case the allocator hooks must be thread-safe. The result must be freed using
+    // `kittycat_patch_check_batch_result_free`
+    struct KittycatPatchCheckBatchResult *kittycat_patch_checker_check_batch(
+        const struct kittycat_patch_checker *const checker,
+        const struct KittycatPermissionList *const *current_perms,
+        const struct KittycatPermissionList *const *new_perms,
+        const size_t n,
+        size_t threads);
+
+    // Frees the KittycatPatchCheckBatchResult
+    void kittycat_patch_check_batch_result_free(struct KittycatPatchCheckBatchResult *result);
+
+    // Frees the kittycat_patch_checker
+    void kittycat_patch_checker_free(struct kittycat_patch_checker *checker);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_PATCH_CHECKER_H
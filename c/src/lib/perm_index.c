@@ -0,0 +1,804 @@
+#include "perm_index.h"
+#include "internal.h"
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_perm_index_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define __KITTYCAT_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define __KITTYCAT_PREFETCH(addr) ((void)(addr))
+#endif
+
+// Flags stored per namespace+perm pair of a KittycatPermissionSet
+#define __KITTYCAT_SET_GRANTED 1
+#define __KITTYCAT_SET_NEGATED 2
+
+// Mixes a packed permission into a well distributed hash (splitmix64 finalizer)
+uint64_t __kittycat_packed_permission_mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Returns the table capacity of a KittycatPermissionSet holding `len` permissions
+//
+// The load factor is kept at or below 50% so that probes stay short
+size_t __kittycat_permission_set_cap(size_t len)
+{
+    size_t cap = 8;
+    while (cap < len * 2)
+    {
+        cap *= 2;
+    }
+    return cap;
+}
+
+// Initializes an empty KittycatPermissionSet over caller provided tables of `cap` (a power of 2) slots
+void __kittycat_permission_set_init(struct KittycatPermissionSet *set, uint64_t *keys, uint8_t *flags, size_t cap)
+{
+    set->len = 0;
+    set->global_star = false;
+    set->__keys = keys;
+    set->__flags = flags;
+    set->__mask = cap - 1;
+    memset(keys, 0, cap * sizeof(uint64_t));
+    memset(flags, 0, cap * sizeof(uint8_t));
+}
+
+struct KittycatPermissionSet *__kittycat_permission_set_new(size_t len)
+{
+    size_t cap = __kittycat_permission_set_cap(len);
+    struct KittycatPermissionSet *set = __kittycat_malloc(sizeof(struct KittycatPermissionSet));
+    __kittycat_permission_set_init(set, __kittycat_malloc(cap * sizeof(uint64_t)), __kittycat_malloc(cap * sizeof(uint8_t)), cap);
+    return set;
+}
+
+void __kittycat_permission_set_insert(struct KittycatPermissionSet *set, uint64_t perm)
+{
+    uint64_t key = perm & ~KITTYCAT_PACKED_PERMISSION_NEGATOR;
+    uint8_t flag = KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(perm) ? __KITTYCAT_SET_NEGATED : __KITTYCAT_SET_GRANTED;
+
+    if (key == KITTYCAT_PACKED_PERMISSION(KITTYCAT_ATOM_GLOBAL, KITTYCAT_ATOM_WILDCARD, false) && flag == __KITTYCAT_SET_GRANTED)
+    {
+        set->global_star = true;
+    }
+
+    size_t i = __kittycat_packed_permission_mix(key) & set->__mask;
+    while (set->__keys[i] != 0 && set->__keys[i] != key)
+    {
+        i = (i + 1) & set->__mask;
+    }
+
+    if (set->__keys[i] == 0)
+    {
+        set->__keys[i] = key;
+        set->len++;
+    }
+    set->__flags[i] |= flag;
+}
+
+// Returns the flags of a (non-negated) packed key with the given hash, or 0 if the set does not contain it
+uint8_t __kittycat_permission_set_flags_with_hash(const struct KittycatPermissionSet *const set, uint64_t key, uint64_t hash)
+{
+    size_t i = hash & set->__mask;
+    while (set->__keys[i] != 0)
+    {
+        if (set->__keys[i] == key)
+        {
+            return set->__flags[i];
+        }
+        i = (i + 1) & set->__mask;
+    }
+    return 0;
+}
+
+struct KittycatPermissionSet *kittycat_permission_set_compile(const struct KittycatPermissionList *const perms)
+{
+    struct KittycatPermissionSet *set = __kittycat_permission_set_new(perms->len);
+
+    for (size_t i = 0; i < perms->len; i++)
+    {
+        __kittycat_permission_set_insert(set, kittycat_permission_pack(perms->perms[i]));
+    }
+
+    return set;
+}
+
+struct KittycatPermissionSet *kittycat_permission_set_compile_packed(const struct KittycatPackedPermissionList *const perms)
+{
+    struct KittycatPermissionSet *set = __kittycat_permission_set_new(perms->len);
+
+    for (size_t i = 0; i < perms->len; i++)
+    {
+        __kittycat_permission_set_insert(set, perms->perms[i]);
+    }
+
+    return set;
+}
+
+// Returns the flags of a (non-negated) packed key, or 0 if the set does not contain it
+uint8_t __kittycat_permission_set_flags(const struct KittycatPermissionSet *const set, uint64_t key)
+{
+    return __kittycat_permission_set_flags_with_hash(set, key, __kittycat_packed_permission_mix(key));
+}
+
+bool kittycat_permission_set_has_packed(const struct KittycatPermissionSet *const set, const uint64_t perm)
+{
+    // Special case of global.*
+    if (set->global_star)
+    {
+        return true;
+    }
+
+    uint32_t namespace_atom = KITTYCAT_PACKED_PERMISSION_NAMESPACE(perm);
+    uint32_t perm_atom = KITTYCAT_PACKED_PERMISSION_PERM(perm);
+
+    // A user permission applies if its namespace is the permissions namespace or global and its perm is the permission or *
+    uint8_t flags = __kittycat_permission_set_flags(set, KITTYCAT_PACKED_PERMISSION(namespace_atom, perm_atom, false)) |
+                    __kittycat_permission_set_flags(set, KITTYCAT_PACKED_PERMISSION(namespace_atom, KITTYCAT_ATOM_WILDCARD, false)) |
+                    __kittycat_permission_set_flags(set, KITTYCAT_PACKED_PERMISSION(KITTYCAT_ATOM_GLOBAL, perm_atom, false)) |
+                    __kittycat_permission_set_flags(set, KITTYCAT_PACKED_PERMISSION(KITTYCAT_ATOM_GLOBAL, KITTYCAT_ATOM_WILDCARD, false));
+
+    return (flags & __KITTYCAT_SET_GRANTED) && !(flags & __KITTYCAT_SET_NEGATED);
+}
+
+bool kittycat_permission_set_has(const struct KittycatPermissionSet *const set, const struct KittycatPermission *const perm)
+{
+    return kittycat_permission_set_has_packed(set, kittycat_permission_pack(perm));
+}
+
+void kittycat_permission_set_free(struct KittycatPermissionSet *set)
+{
+    if (set == NULL)
+    {
+        return;
+    }
+
+    __kittycat_free(set->__keys);
+    __kittycat_free(set->__flags);
+    __kittycat_free(set);
+}
+
+// Largest table used by `kittycat_has_perms_batch` without allocating
+#define __KITTYCAT_BATCH_STACK_CAP 256
+
+void kittycat_permission_set_has_batch(const struct KittycatPermissionSet *const set, const struct KittycatPermission *const *query, const size_t n, uint64_t *out_bitmap)
+{
+    memset(out_bitmap, 0, ((n + 63) / 64) * sizeof(uint64_t));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (kittycat_permission_set_has(set, query[i]))
+        {
+            out_bitmap[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+}
+
+void kittycat_has_perms_batch(const struct KittycatPermissionList *const perms, const struct KittycatPermission *const *query, const size_t n, uint64_t *out_bitmap)
+{
+    size_t cap = __kittycat_permission_set_cap(perms->len);
+
+    // Index the user list once. Typical resolved lists fit a table on the stack
+    struct KittycatPermissionSet set;
+    uint64_t stack_keys[__KITTYCAT_BATCH_STACK_CAP];
+    uint8_t stack_flags[__KITTYCAT_BATCH_STACK_CAP];
+    bool on_stack = cap <= __KITTYCAT_BATCH_STACK_CAP;
+
+    if (on_stack)
+    {
+        __kittycat_permission_set_init(&set, stack_keys, stack_flags, cap);
+    }
+    else
+    {
+        __kittycat_permission_set_init(&set, __kittycat_malloc(cap * sizeof(uint64_t)), __kittycat_malloc(cap * sizeof(uint8_t)), cap);
+    }
+
+    for (size_t i = 0; i < perms->len; i++)
+    {
+        __kittycat_permission_set_insert(&set, kittycat_permission_pack(perms->perms[i]));
+    }
+
+    kittycat_permission_set_has_batch(&set, query, n, out_bitmap);
+
+    if (!on_stack)
+    {
+        __kittycat_free(set.__keys);
+        __kittycat_free(set.__flags);
+    }
+}
+
+/* Permission columns */
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define __KITTYCAT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// Result flags of a permission column scan
+#define __KITTYCAT_SCAN_GRANTED 1
+#define __KITTYCAT_SCAN_NEGATED 2
+#define __KITTYCAT_SCAN_GLOBAL_STAR 4
+
+static enum KittycatSimdLevel __kittycat_max_simd_level = KITTYCAT_SIMD_LEVEL_AVX2;
+
+void kittycat_set_max_simd_level(enum KittycatSimdLevel level)
+{
+    __kittycat_max_simd_level = level;
+}
+
+enum KittycatSimdLevel kittycat_simd_level()
+{
+    enum KittycatSimdLevel level = KITTYCAT_SIMD_LEVEL_SCALAR;
+
+#ifdef __KITTYCAT_X86_SIMD
+    // SSE2 is part of the x86_64 baseline
+    level = __builtin_cpu_supports("avx2") ? KITTYCAT_SIMD_LEVEL_AVX2 : KITTYCAT_SIMD_LEVEL_SSE2;
+#endif
+
+    return level < __kittycat_max_simd_level ? level : __kittycat_max_simd_level;
+}
+
+// Scans permission columns for a permission, returning __KITTYCAT_SCAN_* flags
+//
+// A user permission matches if its namespace is `namespace_atom` or global and its perm is `perm_atom` or *
+uint32_t __kittycat_columns_scan_scalar(const uint32_t *namespaces, const uint32_t *perms, size_t len, uint32_t namespace_atom, uint32_t perm_atom)
+{
+    uint32_t flags = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        uint32_t ns = namespaces[i] & ~KITTYCAT_PERMISSION_COLUMNS_NEGATOR;
+        bool negator = (namespaces[i] & KITTYCAT_PERMISSION_COLUMNS_NEGATOR) != 0;
+
+        // Special case of global.*
+        if (namespaces[i] == KITTYCAT_ATOM_GLOBAL && perms[i] == KITTYCAT_ATOM_WILDCARD)
+        {
+            return __KITTYCAT_SCAN_GLOBAL_STAR;
+        }
+
+        if ((ns == namespace_atom || ns == KITTYCAT_ATOM_GLOBAL) && (perms[i] == KITTYCAT_ATOM_WILDCARD || perms[i] == perm_atom))
+        {
+            flags |= negator ? __KITTYCAT_SCAN_NEGATED : __KITTYCAT_SCAN_GRANTED;
+        }
+    }
+
+    return flags;
+}
+
+#ifdef __KITTYCAT_X86_SIMD
+uint32_t __kittycat_columns_scan_sse2(const uint32_t *namespaces, const uint32_t *perms, size_t len, uint32_t namespace_atom, uint32_t perm_atom)
+{
+    const __m128i q_ns = _mm_set1_epi32((int)namespace_atom);
+    const __m128i q_perm = _mm_set1_epi32((int)perm_atom);
+    const __m128i global = _mm_set1_epi32(KITTYCAT_ATOM_GLOBAL);
+    const __m128i wildcard = _mm_set1_epi32(KITTYCAT_ATOM_WILDCARD);
+    const __m128i ns_mask = _mm_set1_epi32(0x7FFFFFFF);
+
+    __m128i granted = _mm_setzero_si128();
+    __m128i negated = _mm_setzero_si128();
+    __m128i global_star = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        __m128i ns_raw = _mm_loadu_si128((const __m128i *)(namespaces + i));
+        __m128i perm = _mm_loadu_si128((const __m128i *)(perms + i));
+
+        __m128i negator = _mm_srai_epi32(ns_raw, 31);
+        __m128i ns = _mm_and_si128(ns_raw, ns_mask);
+        __m128i is_wildcard = _mm_cmpeq_epi32(perm, wildcard);
+
+        __m128i ns_match = _mm_or_si128(_mm_cmpeq_epi32(ns, q_ns), _mm_cmpeq_epi32(ns, global));
+        __m128i perm_match = _mm_or_si128(_mm_cmpeq_epi32(perm, q_perm), is_wildcard);
+        __m128i match = _mm_and_si128(ns_match, perm_match);
+
+        granted = _mm_or_si128(granted, _mm_andnot_si128(negator, match));
+        negated = _mm_or_si128(negated, _mm_and_si128(negator, match));
+        global_star = _mm_or_si128(global_star, _mm_and_si128(_mm_cmpeq_epi32(ns_raw, global), is_wildcard));
+    }
+
+    if (_mm_movemask_epi8(global_star))
+    {
+        return __KITTYCAT_SCAN_GLOBAL_STAR;
+    }
+
+    uint32_t flags = __kittycat_columns_scan_scalar(namespaces + i, perms + i, len - i, namespace_atom, perm_atom);
+    if (_mm_movemask_epi8(granted))
+    {
+        flags |= __KITTYCAT_SCAN_GRANTED;
+    }
+    if (_mm_movemask_epi8(negated))
+    {
+        flags |= __KITTYCAT_SCAN_NEGATED;
+    }
+    return flags;
+}
+
+__attribute__((target("avx2"))) uint32_t __kittycat_columns_scan_avx2(const uint32_t *namespaces, const uint32_t *perms, size_t len, uint32_t namespace_atom, uint32_t perm_atom)
+{
+    const __m256i q_ns = _mm256_set1_epi32((int)namespace_atom);
+    const __m256i q_perm = _mm256_set1_epi32((int)perm_atom);
+    const __m256i global = _mm256_set1_epi32(KITTYCAT_ATOM_GLOBAL);
+    const __m256i wildcard = _mm256_set1_epi32(KITTYCAT_ATOM_WILDCARD);
+    const __m256i ns_mask = _mm256_set1_epi32(0x7FFFFFFF);
+
+    __m256i granted = _mm256_setzero_si256();
+    __m256i negated = _mm256_setzero_si256();
+    __m256i global_star = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        __m256i ns_raw = _mm256_loadu_si256((const __m256i *)(namespaces + i));
+        __m256i perm = _mm256_loadu_si256((const __m256i *)(perms + i));
+
+        __m256i negator = _mm256_srai_epi32(ns_raw, 31);
+        __m256i ns = _mm256_and_si256(ns_raw, ns_mask);
+        __m256i is_wildcard = _mm256_cmpeq_epi32(perm, wildcard);
+
+        __m256i ns_match = _mm256_or_si256(_mm256_cmpeq_epi32(ns, q_ns), _mm256_cmpeq_epi32(ns, global));
+        __m256i perm_match = _mm256_or_si256(_mm256_cmpeq_epi32(perm, q_perm), is_wildcard);
+        __m256i match = _mm256_and_si256(ns_match, perm_match);
+
+        granted = _mm256_or_si256(granted, _mm256_andnot_si256(negator, match));
+        negated = _mm256_or_si256(negated, _mm256_and_si256(negator, match));
+        global_star = _mm256_or_si256(global_star, _mm256_and_si256(_mm256_cmpeq_epi32(ns_raw, global), is_wildcard));
+    }
+
+    if (_mm256_movemask_epi8(global_star))
+    {
+        return __KITTYCAT_SCAN_GLOBAL_STAR;
+    }
+
+    // Finish the remaining (less than 8) permissions with SSE2 and scalar code
+    uint32_t flags = __kittycat_columns_scan_sse2(namespaces + i, perms + i, len - i, namespace_atom, perm_atom);
+    if (_mm256_movemask_epi8(granted))
+    {
+        flags |= __KITTYCAT_SCAN_GRANTED;
+    }
+    if (_mm256_movemask_epi8(negated))
+    {
+        flags |= __KITTYCAT_SCAN_NEGATED;
+    }
+    return flags;
+}
+#endif
+
+// Returns the best scan kernel for this CPU
+uint32_t (*__kittycat_columns_scan_kernel())(const uint32_t *, const uint32_t *, size_t, uint32_t, uint32_t)
+{
+    switch (kittycat_simd_level())
+    {
+#ifdef __KITTYCAT_X86_SIMD
+    case KITTYCAT_SIMD_LEVEL_AVX2:
+        return __kittycat_columns_scan_avx2;
+    case KITTYCAT_SIMD_LEVEL_SSE2:
+        return __kittycat_columns_scan_sse2;
+#endif
+    default:
+        return __kittycat_columns_scan_scalar;
+    }
+}
+
+bool __kittycat_columns_scan_result(uint32_t flags)
+{
+    return (flags & __KITTYCAT_SCAN_GLOBAL_STAR) || ((flags & __KITTYCAT_SCAN_GRANTED) && !(flags & __KITTYCAT_SCAN_NEGATED));
+}
+
+void __kittycat_permission_columns_init(struct KittycatPermissionColumns *columns, size_t len)
+{
+    columns->namespaces = __kittycat_malloc((len > 0 ? len : 1) * sizeof(uint32_t));
+    columns->perms = __kittycat_malloc((len > 0 ? len : 1) * sizeof(uint32_t));
+    columns->len = len;
+}
+
+void __kittycat_permission_columns_set(struct KittycatPermissionColumns *columns, size_t i, uint64_t packed)
+{
+    columns->namespaces[i] = KITTYCAT_PACKED_PERMISSION_NAMESPACE(packed) | (KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(packed) ? KITTYCAT_PERMISSION_COLUMNS_NEGATOR : 0);
+    columns->perms[i] = KITTYCAT_PACKED_PERMISSION_PERM(packed);
+}
+
+struct KittycatPermissionColumns *kittycat_permission_columns_new(const struct KittycatPermissionList *const perms)
+{
+    struct KittycatPermissionColumns *columns = __kittycat_malloc(sizeof(struct KittycatPermissionColumns));
+    __kittycat_permission_columns_init(columns, perms->len);
+
+    for (size_t i = 0; i < perms->len; i++)
+    {
+        __kittycat_permission_columns_set(columns, i, kittycat_permission_pack(perms->perms[i]));
+    }
+
+    return columns;
+}
+
+struct KittycatPermissionColumns *kittycat_permission_columns_new_packed(const struct KittycatPackedPermissionList *const perms)
+{
+    struct KittycatPermissionColumns *columns = __kittycat_malloc(sizeof(struct KittycatPermissionColumns));
+    __kittycat_permission_columns_init(columns, perms->len);
+
+    for (size_t i = 0; i < perms->len; i++)
+    {
+        __kittycat_permission_columns_set(columns, i, perms->perms[i]);
+    }
+
+    return columns;
+}
+
+bool kittycat_permission_columns_has_perm(const struct KittycatPermissionColumns *const columns, const struct KittycatPermission *const perm)
+{
+    uint32_t flags = __kittycat_columns_scan_kernel()(columns->namespaces, columns->perms, columns->len, perm->namespace_atom, perm->perm_atom);
+    return __kittycat_columns_scan_result(flags);
+}
+
+void kittycat_permission_columns_free(struct KittycatPermissionColumns *columns)
+{
+    if (columns == NULL)
+    {
+        return;
+    }
+
+    __kittycat_free(columns->namespaces);
+    __kittycat_free(columns->perms);
+    __kittycat_free(columns);
+}
+
+/* Multi-user checks */
+
+struct KittycatPermissionListBatch *kittycat_permission_list_batch_new(const struct KittycatPermissionList *const *lists, const size_t n)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        total += lists[i]->len;
+    }
+
+    struct KittycatPermissionListBatch *batch = __kittycat_malloc(sizeof(struct KittycatPermissionListBatch));
+    batch->len = n;
+    __kittycat_permission_columns_init(&batch->columns, total);
+    batch->offsets = __kittycat_malloc((n + 1) * sizeof(size_t));
+
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        batch->offsets[i] = k;
+        for (size_t j = 0; j < lists[i]->len; j++)
+        {
+            __kittycat_permission_columns_set(&batch->columns, k, kittycat_permission_pack(lists[i]->perms[j]));
+            k++;
+        }
+    }
+    batch->offsets[n] = k;
+
+    return batch;
+}
+
+void kittycat_permission_list_batch_has_perm(const struct KittycatPermissionListBatch *const batch, const struct KittycatPermission *const perm, uint64_t *out_bitmap)
+{
+    memset(out_bitmap, 0, ((batch->len + 63) / 64) * sizeof(uint64_t));
+
+    uint32_t (*scan)(const uint32_t *, const uint32_t *, size_t, uint32_t, uint32_t) = __kittycat_columns_scan_kernel();
+
+    // Users are stored back to back so this is a single forward scan over the columns
+    for (size_t i = 0; i < batch->len; i++)
+    {
+        size_t start = batch->offsets[i];
+        size_t end = batch->offsets[i + 1];
+
+        uint32_t flags = scan(batch->columns.namespaces + start, batch->columns.perms + start, end - start, perm->namespace_atom, perm->perm_atom);
+        if (__kittycat_columns_scan_result(flags))
+        {
+            out_bitmap[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+}
+
+void kittycat_permission_list_batch_free(struct KittycatPermissionListBatch *batch)
+{
+    if (batch == NULL)
+    {
+        return;
+    }
+
+    __kittycat_free(batch->columns.namespaces);
+    __kittycat_free(batch->columns.perms);
+    __kittycat_free(batch->offsets);
+    __kittycat_free(batch);
+}
+
+// How many sets ahead `kittycat_permission_sets_has_perm` prefetches
+#define __KITTYCAT_SETS_PREFETCH_DISTANCE 4
+
+void kittycat_permission_sets_has_perm(const struct KittycatPermissionSet *const *sets, const size_t n, const struct KittycatPermission *const perm, uint64_t *out_bitmap)
+{
+    memset(out_bitmap, 0, ((n + 63) / 64) * sizeof(uint64_t));
+
+    // The four keys that can apply to perm, hashed once for all sets
+    uint64_t keys[4] = {
+        KITTYCAT_PACKED_PERMISSION(perm->namespace_atom, perm->perm_atom, false),
+        KITTYCAT_PACKED_PERMISSION(perm->namespace_atom, KITTYCAT_ATOM_WILDCARD, false),
+        KITTYCAT_PACKED_PERMISSION(KITTYCAT_ATOM_GLOBAL, perm->perm_atom, false),
+        KITTYCAT_PACKED_PERMISSION(KITTYCAT_ATOM_GLOBAL, KITTYCAT_ATOM_WILDCARD, false),
+    };
+    uint64_t hashes[4];
+    for (int k = 0; k < 4; k++)
+    {
+        hashes[k] = __kittycat_packed_permission_mix(keys[k]);
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (i + __KITTYCAT_SETS_PREFETCH_DISTANCE < n)
+        {
+            const struct KittycatPermissionSet *next = sets[i + __KITTYCAT_SETS_PREFETCH_DISTANCE];
+            for (int k = 0; k < 4; k++)
+            {
+                __KITTYCAT_PREFETCH(&next->__keys[hashes[k] & next->__mask]);
+            }
+        }
+
+        const struct KittycatPermissionSet *set = sets[i];
+        bool has;
+        if (set->global_star)
+        {
+            has = true;
+        }
+        else
+        {
+            uint8_t flags = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                flags |= __kittycat_permission_set_flags_with_hash(set, keys[k], hashes[k]);
+            }
+            has = (flags & __KITTYCAT_SET_GRANTED) && !(flags & __KITTYCAT_SET_NEGATED);
+        }
+
+        if (has)
+        {
+            out_bitmap[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+}
+
+/* Permission schemas */
+
+struct KittycatPermissionSchema *__kittycat_permission_schema_new(size_t len)
+{
+    size_t cap = 8;
+    while (cap < len * 2)
+    {
+        cap *= 2;
+    }
+
+    struct KittycatPermissionSchema *schema = __kittycat_malloc(sizeof(struct KittycatPermissionSchema));
+    schema->perms = __kittycat_malloc((len > 0 ? len : 1) * sizeof(uint64_t));
+    schema->len = 0;
+    schema->__keys = __kittycat_malloc(cap * sizeof(uint64_t));
+    schema->__indices = __kittycat_malloc(cap * sizeof(size_t));
+    schema->__mask = cap - 1;
+    memset(schema->__keys, 0, cap * sizeof(uint64_t));
+    return schema;
+}
+
+// Adds a permission to the schema if it is not already in it. The schema must have been created with enough room
+void __kittycat_permission_schema_add(struct KittycatPermissionSchema *schema, const char *str, size_t len)
+{
+    uint64_t key = kittycat_permission_pack_str(str, len) & ~KITTYCAT_PACKED_PERMISSION_NEGATOR;
+
+    size_t i = __kittycat_packed_permission_mix(key) & schema->__mask;
+    while (schema->__keys[i] != 0)
+    {
+        if (schema->__keys[i] == key)
+        {
+            return; // Duplicate
+        }
+        i = (i + 1) & schema->__mask;
+    }
+
+    schema->__keys[i] = key;
+    schema->__indices[i] = schema->len;
+    schema->perms[schema->len] = key;
+    schema->len++;
+}
+
+struct KittycatPermissionSchema *kittycat_permission_schema_new(const char *const *perms, const size_t len)
+{
+    struct KittycatPermissionSchema *schema = __kittycat_permission_schema_new(len);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        __kittycat_permission_schema_add(schema, perms[i], strlen(perms[i]));
+    }
+
+    return schema;
+}
+
+bool __kittycat_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+struct KittycatPermissionSchema *kittycat_permission_schema_load(FILE *stream)
+{
+    // Read the whole manifest
+    size_t cap = 4096;
+    size_t len = 0;
+    char *buf = __kittycat_malloc(cap);
+
+    while (true)
+    {
+        if (len == cap)
+        {
+            cap *= 2;
+            buf = __kittycat_realloc(buf, cap);
+        }
+
+        size_t n = fread(buf + len, 1, cap - len, stream);
+        len += n;
+
+        if (n == 0)
+        {
+            break;
+        }
+    }
+
+    if (ferror(stream))
+    {
+        __kittycat_free(buf);
+        return NULL;
+    }
+
+    // Count lines to size the schema
+    size_t lines = 1;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (buf[i] == '\n')
+        {
+            lines++;
+        }
+    }
+
+    struct KittycatPermissionSchema *schema = __kittycat_permission_schema_new(lines);
+
+    size_t start = 0;
+    while (start < len)
+    {
+        const char *nl = memchr(buf + start, '\n', len - start);
+        size_t end = nl == NULL ? len : (size_t)(nl - buf);
+        size_t next = end + 1;
+
+        // Trim whitespace
+        while (start < end && __kittycat_is_space(buf[start]))
+        {
+            start++;
+        }
+        while (end > start && __kittycat_is_space(buf[end - 1]))
+        {
+            end--;
+        }
+
+        if (end > start && buf[start] != '#')
+        {
+            __kittycat_permission_schema_add(schema, buf + start, end - start);
+        }
+
+        start = next;
+    }
+
+    __kittycat_free(buf);
+    return schema;
+}
+
+size_t kittycat_permission_schema_index(const struct KittycatPermissionSchema *const schema, const struct KittycatPermission *const perm)
+{
+    uint64_t key = KITTYCAT_PACKED_PERMISSION(perm->namespace_atom, perm->perm_atom, false);
+
+    size_t i = __kittycat_packed_permission_mix(key) & schema->__mask;
+    while (schema->__keys[i] != 0)
+    {
+        if (schema->__keys[i] == key)
+        {
+            return schema->__indices[i];
+        }
+        i = (i + 1) & schema->__mask;
+    }
+
+    return KITTYCAT_PERMISSION_SCHEMA_NOT_FOUND;
+}
+
+void kittycat_permission_schema_free(struct KittycatPermissionSchema *schema)
+{
+    if (schema == NULL)
+    {
+        return;
+    }
+
+    __kittycat_free(schema->perms);
+    __kittycat_free(schema->__keys);
+    __kittycat_free(schema->__indices);
+    __kittycat_free(schema);
+}
+
+/* Permission bitsets */
+
+struct KittycatPermissionBitset *kittycat_permission_bitset_from_set(const struct KittycatPermissionSchema *const schema, const struct KittycatPermissionSet *const set)
+{
+    struct KittycatPermissionBitset *bs = __kittycat_malloc(sizeof(struct KittycatPermissionBitset));
+    bs->nwords = (schema->len + 63) / 64;
+    bs->words = __kittycat_malloc((bs->nwords > 0 ? bs->nwords : 1) * sizeof(uint64_t));
+    memset(bs->words, 0, (bs->nwords > 0 ? bs->nwords : 1) * sizeof(uint64_t));
+
+    for (size_t i = 0; i < schema->len; i++)
+    {
+        if (kittycat_permission_set_has_packed(set, schema->perms[i]))
+        {
+            bs->words[i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+
+    return bs;
+}
+
+struct KittycatPermissionBitset *kittycat_permission_bitset_new(const struct KittycatPermissionSchema *const schema, const struct KittycatPermissionList *const perms)
+{
+    struct KittycatPermissionSet *set = kittycat_permission_set_compile(perms);
+    struct KittycatPermissionBitset *bs = kittycat_permission_bitset_from_set(schema, set);
+    kittycat_permission_set_free(set);
+    return bs;
+}
+
+bool kittycat_permission_bitset_has(const struct KittycatPermissionBitset *const bs, const size_t index)
+{
+    if (index / 64 >= bs->nwords)
+    {
+        return false;
+    }
+
+    return (bs->words[index / 64] >> (index % 64)) & 1;
+}
+
+bool kittycat_permission_bitset_contains(const struct KittycatPermissionBitset *const bs, const struct KittycatPermissionBitset *const other)
+{
+    for (size_t i = 0; i < other->nwords; i++)
+    {
+        uint64_t word = i < bs->nwords ? bs->words[i] : 0;
+        if ((other->words[i] & ~word) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool kittycat_permission_bitset_equal(const struct KittycatPermissionBitset *const bs1, const struct KittycatPermissionBitset *const bs2)
+{
+    return kittycat_permission_bitset_contains(bs1, bs2) && kittycat_permission_bitset_contains(bs2, bs1);
+}
+
+void kittycat_permission_bitset_free(struct KittycatPermissionBitset *bs)
+{
+    if (bs == NULL)
+    {
+        return;
+    }
+
+    __kittycat_free(bs->words);
+    __kittycat_free(bs);
+}
@@ -0,0 +1,216 @@
+#ifndef KITTYCAT_PERM_INDEX_H
+#define KITTYCAT_PERM_INDEX_H
+
+#include "perms.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator for the kittycat permission index code (compiled permission sets)
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_perm_index_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // A compiled, immutable index over a resolved KittycatPermissionList
+    //
+    // Checking a permission against a KittycatPermissionSet returns exactly what `kittycat_has_perm` returns
+    // for the list it was compiled from, but in constant time
+    struct KittycatPermissionSet
+    {
+        // Number of distinct namespace+perm pairs in the set
+        size_t len;
+
+        // Whether the list contained `global.*`, in which case every permission is granted
+        bool global_star;
+
+        // Internal: open addressing table keyed by the non-negated packed permission.
+        // A key of 0 marks an empty slot as no permission has both a namespace and perm atom of 0
+        uint64_t *__keys;
+        uint8_t *__flags;
+        size_t __mask;
+    };
+
+    // Compiles a resolved KittycatPermissionList into a KittycatPermissionSet
+    //
+    // The set does not reference `perms` after this call. The returned set must be freed by the caller using `kittycat_permission_set_free`
+    struct KittycatPermissionSet *kittycat_permission_set_compile(const struct KittycatPermissionList *const perms);
+
+    // Same as `kittycat_permission_set_compile` but for a packed permission list
+    struct KittycatPermissionSet *kittycat_permission_set_compile_packed(const struct KittycatPackedPermissionList *const perms);
+
+    // Resolves the KittycatPermissions of a staff member straight into a KittycatPermissionSet
+    //
+    // This is equivalent to compiling the result of `kittycat_staff_permissions_resolve`, without building (and freeing) the resolved
+    // KittycatPermissionList in between. Use `kittycat_staff_permissions_resolve` when the order of the resolved permissions matters
+    struct KittycatPermissionSet *kittycat_staff_permissions_resolve_to_set(const struct StaffKittycatPermissions *const sp);
+
+    // Returns if the set has permission `perm`. This is equivalent to `kittycat_has_perm` on the compiled list
+    bool kittycat_permission_set_has(const struct KittycatPermissionSet *const set, const struct KittycatPermission *const perm);
+
+    // Same as `kittycat_permission_set_has` but for a packed permission
+    bool kittycat_permission_set_has_packed(const struct KittycatPermissionSet *const set, const uint64_t perm);
+
+    // Frees the KittycatPermissionSet
+    void kittycat_permission_set_free(struct KittycatPermissionSet *set);
+
+    // Checks `n` permissions against the user permission list `perms` at once
+    //
+    // Bit `i % 64` of `out_bitmap[i / 64]` is set to the result of `kittycat_has_perm(perms, query[i])`. `out_bitmap` must hold at least `(n + 63) / 64` words.
+    // The user list is only walked once, making this O(perms->len + n) instead of O(perms->len * n)
+    void kittycat_has_perms_batch(const struct KittycatPermissionList *const perms, const struct KittycatPermission *const *query, const size_t n, uint64_t *out_bitmap);
+
+    // Same as `kittycat_has_perms_batch` but against an already compiled KittycatPermissionSet
+    void kittycat_permission_set_has_batch(const struct KittycatPermissionSet *const set, const struct KittycatPermission *const *query, const size_t n, uint64_t *out_bitmap);
+
+    // The SIMD instruction sets permission column scans can use
+    enum KittycatSimdLevel
+    {
+        KITTYCAT_SIMD_LEVEL_SCALAR,
+        KITTYCAT_SIMD_LEVEL_SSE2,
+        KITTYCAT_SIMD_LEVEL_AVX2,
+    };
+
+    // Returns the SIMD level permission column scans use on this CPU
+    //
+    // The level is detected at runtime (through cpuid) and capped by `kittycat_set_max_simd_level`
+    enum KittycatSimdLevel kittycat_simd_level();
+
+    // Caps the SIMD level permission column scans may use. This is mostly useful for testing and benchmarking
+    //
+    // Like `kittycat_set_allocator`, this should be called before any other kittycat library functions
+    void kittycat_set_max_simd_level(enum KittycatSimdLevel level);
+
+    // Set on a namespace of a KittycatPermissionColumns if the permission is a negator
+#define KITTYCAT_PERMISSION_COLUMNS_NEGATOR ((uint32_t)1 << 31)
+
+    // A permission list stored as a struct of arrays so that `kittycat_has_perm` can compare many permissions at once with SIMD
+    struct KittycatPermissionColumns
+    {
+        // The namespace atom of each permission, with `KITTYCAT_PERMISSION_COLUMNS_NEGATOR` set for negators
+        uint32_t *namespaces;
+        // The perm atom of each permission
+        uint32_t *perms;
+        size_t len;
+    };
+
+    // Creates a new KittycatPermissionColumns from a KittycatPermissionList
+    //
+    // The returned columns must be freed by the caller using `kittycat_permission_columns_free`
+    struct KittycatPermissionColumns *kittycat_permission_columns_new(const struct KittycatPermissionList *const perms);
+
+    // Same as `kittycat_permission_columns_new` but for a packed permission list
+    struct KittycatPermissionColumns *kittycat_permission_columns_new_packed(const struct KittycatPackedPermissionList *const perms);
+
+    // Same as `kittycat_has_perm` but for permission columns
+    bool kittycat_permission_columns_has_perm(const struct KittycatPermissionColumns *const columns, const struct KittycatPermission *const perm);
+
+    // Frees the KittycatPermissionColumns
+    void kittycat_permission_columns_free(struct KittycatPermissionColumns *columns);
+
+    // Many users permission lists stored back to back in one set of permission columns for checking one permission against all of them
+    //
+    // User `i` has the permissions at `offsets[i]` up to (not including) `offsets[i + 1]` of `columns`
+    struct KittycatPermissionListBatch
+    {
+        // Number of users
+        size_t len;
+        struct KittycatPermissionColumns columns;
+        size_t *offsets;
+    };
+
+    // Creates a new KittycatPermissionListBatch from `n` resolved KittycatPermissionLists
+    //
+    // The batch does not reference `lists` after this call. The returned batch must be freed by the caller using `kittycat_permission_list_batch_free`
+    struct KittycatPermissionListBatch *kittycat_permission_list_batch_new(const struct KittycatPermissionList *const *lists, const size_t n);
+
+    // Checks permission `perm` against every user of the batch
+    //
+    // Bit `i % 64` of `out_bitmap[i / 64]` is set to the result of `kittycat_has_perm` for user `i`. `out_bitmap` must hold at least `(batch->len + 63) / 64` words
+    void kittycat_permission_list_batch_has_perm(const struct KittycatPermissionListBatch *const batch, const struct KittycatPermission *const perm, uint64_t *out_bitmap);
+
+    // Frees the KittycatPermissionListBatch
+    void kittycat_permission_list_batch_free(struct KittycatPermissionListBatch *batch);
+
+    // Same as `kittycat_permission_list_batch_has_perm` but checks `n` compiled KittycatPermissionSets
+    //
+    // The probe keys of `perm` are hashed once for all sets and the tables of upcoming sets are prefetched while the current one is checked
+    void kittycat_permission_sets_has_perm(const struct KittycatPermissionSet *const *sets, const size_t n, const struct KittycatPermission *const perm, uint64_t *out_bitmap);
+
+    // A permission schema assigns a dense index to every permission in a fixed, known universe of permissions
+    //
+    // This allows lowering resolved KittycatPermissionLists to KittycatPermissionBitsets where checking a permission is a single bit test
+    struct KittycatPermissionSchema
+    {
+        // The packed (non-negated) permission at each index
+        uint64_t *perms;
+        size_t len;
+
+        // Internal: open addressing table mapping packed permissions to their index
+        uint64_t *__keys;
+        size_t *__indices;
+        size_t __mask;
+    };
+
+    // Returned by `kittycat_permission_schema_index` when a permission is not part of the schema
+#define KITTYCAT_PERMISSION_SCHEMA_NOT_FOUND ((size_t)-1)
+
+    // Creates a new KittycatPermissionSchema from an array of `len` canonical permission strings
+    //
+    // Indices are assigned in order of first appearance. Negators are ignored and duplicates share one index
+    struct KittycatPermissionSchema *kittycat_permission_schema_new(const char *const *perms, const size_t len);
+
+    // Creates a new KittycatPermissionSchema from a manifest read from `stream`
+    //
+    // A manifest holds one canonical permission per line. Leading/trailing whitespace is ignored as are empty lines and lines starting with `#`.
+    // Returns NULL if reading `stream` fails
+    struct KittycatPermissionSchema *kittycat_permission_schema_load(FILE *stream);
+
+    // Returns the index of `perm` in the schema, or `KITTYCAT_PERMISSION_SCHEMA_NOT_FOUND` if the schema does not contain it
+    size_t kittycat_permission_schema_index(const struct KittycatPermissionSchema *const schema, const struct KittycatPermission *const perm);
+
+    // Frees the KittycatPermissionSchema
+    void kittycat_permission_schema_free(struct KittycatPermissionSchema *schema);
+
+    // A dense bitset of the permissions of a KittycatPermissionSchema that a user has
+    //
+    // Bit `i` is set if and only if `kittycat_has_perm` returns true for the permission at index `i` of the schema
+    struct KittycatPermissionBitset
+    {
+        uint64_t *words;
+        size_t nwords;
+    };
+
+    // Lowers a resolved KittycatPermissionList to a KittycatPermissionBitset of `schema`. Wildcards, `global.*` and negators are all applied
+    //
+    // The returned bitset must be freed by the caller using `kittycat_permission_bitset_free`
+    struct KittycatPermissionBitset *kittycat_permission_bitset_new(const struct KittycatPermissionSchema *const schema, const struct KittycatPermissionList *const perms);
+
+    // Same as `kittycat_permission_bitset_new` but lowers an already compiled KittycatPermissionSet
+    struct KittycatPermissionBitset *kittycat_permission_bitset_from_set(const struct KittycatPermissionSchema *const schema, const struct KittycatPermissionSet *const set);
+
+    // Returns if the permission at `index` in the schema is set
+    bool kittycat_permission_bitset_has(const struct KittycatPermissionBitset *const bs, const size_t index);
+
+    // Returns if `bs` has every permission that `other` has. Both bitsets must be of the same schema
+    bool kittycat_permission_bitset_contains(const struct KittycatPermissionBitset *const bs, const struct KittycatPermissionBitset *const other);
+
+    // Returns if two bitsets of the same schema hold the same permissions
+    bool kittycat_permission_bitset_equal(const struct KittycatPermissionBitset *const bs1, const struct KittycatPermissionBitset *const bs2);
+
+    // Frees the KittycatPermissionBitset
+    void kittycat_permission_bitset_free(struct KittycatPermissionBitset *bs);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_PERM_INDEX_H
@@ -1,5 +1,9 @@
 #include "perms.h"
 #include "hashmap.h"
+#include "internal.h"
+#include "arena.h"
+#include "perm_index.h"
+#include <stdlib.h>
 
 static void *(*__kittycat_malloc)(size_t) = NULL;
 static void *(*__kittycat_realloc)(void *, size_t) = NULL;
@@ -15,91 +19,168 @@ void kittycat_perms_set_allocator(
     __kittycat_free = free;
 }
 
-const struct kittycat_string __kittycat_perm_global_ns = {"global", 6, false};
-const struct kittycat_string __kittycat_perm_clear_perm = {"@clear", 6, false};
-const struct kittycat_string __kittycat_perm_global_perm = {"*", 1, false};
+// Allocates `size` bytes in `arena`, or on the heap if `arena` is NULL
+void *__kittycat_perms_alloc(struct kittycat_arena *arena, size_t size)
+{
+    return arena != NULL ? kittycat_arena_alloc(arena, size) : __kittycat_malloc(size);
+}
+
+void *__kittycat_perms_realloc(struct kittycat_arena *arena, void *ptr, size_t size)
+{
+    return arena != NULL ? kittycat_arena_realloc(arena, ptr, size) : __kittycat_realloc(ptr, size);
+}
 
 struct KittycatPermission *kittycat_new_permission(struct kittycat_string *namespace, struct kittycat_string *perm, bool negator)
 {
-    struct KittycatPermission *p = __kittycat_malloc(sizeof(struct KittycatPermission));
+    return kittycat_new_permission_in_arena(NULL, namespace, perm, negator);
+}
+
+struct KittycatPermission *kittycat_new_permission_in_arena(struct kittycat_arena *arena, struct kittycat_string *namespace, struct kittycat_string *perm, bool negator)
+{
+    struct KittycatPermission *p = __kittycat_perms_alloc(arena, sizeof(struct KittycatPermission));
     p->namespace = namespace;
     p->perm = perm;
     p->negator = negator;
-    p->__isCloned = false;
+    p->namespace_atom = kittycat_string_intern_str(namespace);
+    p->perm_atom = kittycat_string_intern_str(perm);
+    p->ownership = KITTYCAT_PERMISSION_OWNERSHIP_CALLER;
+    p->__arena = arena;
     return p;
 }
 
-struct KittycatPermission *kittycat_new_permission_cloned(struct kittycat_string *namespace, struct kittycat_string *perm, bool negator)
+struct KittycatPermission *__kittycat_new_permission_from_atoms(uint32_t namespace_atom, uint32_t perm_atom, bool negator)
+{
+    return __kittycat_new_permission_from_atoms_in_arena(NULL, namespace_atom, perm_atom, negator);
+}
+
+struct KittycatPermission *__kittycat_new_permission_from_atoms_in_arena(struct kittycat_arena *arena, uint32_t namespace_atom, uint32_t perm_atom, bool negator)
 {
-    struct KittycatPermission *p = __kittycat_malloc(sizeof(struct KittycatPermission));
-    p->namespace = kittycat_string_clone(namespace);
-    p->perm = kittycat_string_clone(perm);
+    struct KittycatPermission *p = __kittycat_perms_alloc(arena, sizeof(struct KittycatPermission));
+    p->namespace = kittycat_string_atom_str(namespace_atom);
+    p->perm = kittycat_string_atom_str(perm_atom);
     p->negator = negator;
-    p->__isCloned = true;
+    p->namespace_atom = namespace_atom;
+    p->perm_atom = perm_atom;
+    p->ownership = KITTYCAT_PERMISSION_OWNERSHIP_INTERNED;
+    p->__arena = arena;
     return p;
 }
 
-struct KittycatPermission *kittycat_permission_new_from_str(struct kittycat_string *str)
+struct KittycatPermission *kittycat_new_permission_cloned(struct kittycat_string *namespace, struct kittycat_string *perm, bool negator)
 {
-    if (str->len == 0)
+    return __kittycat_new_permission_from_atoms(kittycat_string_intern_str(namespace), kittycat_string_intern_str(perm), negator);
+}
+
+uint8_t __kittycat_permission_classify(const struct KittycatPermission *const p)
+{
+    uint8_t kind = p->negator ? __KITTYCAT_ENTRY_NEGATOR : 0;
+    if (p->perm_atom == KITTYCAT_ATOM_CLEAR)
     {
-        return NULL;
+        kind |= p->namespace_atom == KITTYCAT_ATOM_GLOBAL ? (__KITTYCAT_ENTRY_CLEAR | __KITTYCAT_ENTRY_GLOBAL_CLEAR) : __KITTYCAT_ENTRY_CLEAR;
     }
-
-    struct kittycat_string *str_split[2];
-    int split = kittycat_string_splitn(str, '.', str_split, 2);
-
-    if (split == 0)
+    else if (p->perm_atom == KITTYCAT_ATOM_WILDCARD && !p->negator)
     {
-        return NULL;
+        kind |= __KITTYCAT_ENTRY_WILDCARD;
     }
+    return kind;
+}
 
+void __kittycat_permission_split(const char *str, size_t len, const char **ns, size_t *ns_len, const char **perm, size_t *perm_len, bool *negator)
+{
     // If first character is ~, then it is a negator
-    bool negator = str_split[0]->str[0] == '~';
+    *negator = len > 0 && str[0] == '~';
 
     // If negator, remove the ~
-    if (negator)
+    size_t start = 0;
+    while (start < len && str[start] == '~')
     {
-        struct kittycat_string *new_perm = kittycat_string_trim_prefix(str_split[0], '~');
-        kittycat_string_free(str_split[0]);
-        str_split[0] = new_perm;
+        start++;
     }
 
+    const char *dot = memchr(str + start, '.', len - start);
+
     // If perm is empty, then namespace is global and perm is first part
-    struct KittycatPermission *p;
-    if (split < 2)
+    if (dot == NULL)
     {
-        p = kittycat_new_permission(kittycat_string_new("global", strlen("global")), str_split[0], negator);
-        p->__isCloned = true; // substr clones the string, so flag it as cloned
+        *ns = NULL;
+        *ns_len = 0;
+        *perm = str + start;
+        *perm_len = len - start;
+        return;
     }
-    else
+
+    *ns = str + start;
+    *ns_len = (size_t)(dot - *ns);
+    *perm = dot + 1;
+    *perm_len = len - (size_t)(*perm - str);
+}
+
+struct KittycatPermission *kittycat_permission_new_from_str(struct kittycat_string *str)
+{
+    return kittycat_permission_new_from_str_in_arena(NULL, str);
+}
+
+struct KittycatPermission *kittycat_permission_new_from_str_in_arena(struct kittycat_arena *arena, struct kittycat_string *str)
+{
+    if (str->len == 0)
     {
-        p = kittycat_new_permission(str_split[0], str_split[1], negator);
-        p->__isCloned = true; // substr clones the string, so flag it as cloned
+        return NULL;
     }
 
-    return p;
+    const char *ns;
+    const char *perm;
+    size_t ns_len;
+    size_t perm_len;
+    bool negator;
+    __kittycat_permission_split(str->str, str->len, &ns, &ns_len, &perm, &perm_len, &negator);
+
+    return __kittycat_new_permission_from_atoms_in_arena(
+        arena,
+        ns == NULL ? KITTYCAT_ATOM_GLOBAL : kittycat_string_intern(ns, ns_len),
+        kittycat_string_intern(perm, perm_len),
+        negator);
 }
 
-struct kittycat_string *kittycat_permission_to_str(struct KittycatPermission *p)
+bool kittycat_permission_view_parse(const char *const str, const size_t len, struct KittycatPermissionView *out)
 {
-    // KittycatPermissions are of the form `namespace.perm`
-    char *finalPerm;
-    size_t len;
-
-    if (p->negator)
+    if (len == 0)
     {
-        len = p->namespace->len + p->perm->len + 3;
-        finalPerm = __kittycat_malloc(len);
-        snprintf(finalPerm, len, "~%s.%s", p->namespace->str, p->perm->str);
+        return false;
     }
-    else
+
+    const char *ns;
+    const char *perm;
+    size_t ns_len;
+    size_t perm_len;
+    __kittycat_permission_split(str, len, &ns, &ns_len, &perm, &perm_len, &out->negator);
+
+    if (ns == NULL)
     {
-        len = p->namespace->len + p->perm->len + 2;
-        finalPerm = __kittycat_malloc(len);
-        snprintf(finalPerm, len, "%s.%s", p->namespace->str, p->perm->str);
+        ns = "global";
+        ns_len = 6;
     }
 
+    out->namespace = (struct kittycat_string_view){ns, ns_len};
+    out->perm = (struct kittycat_string_view){perm, perm_len};
+    return true;
+}
+
+struct KittycatPermission *kittycat_permission_new_from_view(const struct KittycatPermissionView *const view)
+{
+    return __kittycat_new_permission_from_atoms(
+        kittycat_string_intern(view->namespace.str, view->namespace.len),
+        kittycat_string_intern(view->perm.str, view->perm.len),
+        view->negator);
+}
+
+struct kittycat_string *kittycat_permission_to_str(struct KittycatPermission *p)
+{
+    // KittycatPermissions are of the form `namespace.perm`. Caller owned namespace and perm strings need not be
+    // NUL terminated, so always print them with an explicit length
+    size_t len = p->namespace->len + p->perm->len + (p->negator ? 2 : 1);
+    char *finalPerm = __kittycat_malloc(len + 1);
+    snprintf(finalPerm, len + 1, "%s%.*s.%.*s", p->negator ? "~" : "", (int)p->namespace->len, p->namespace->str, (int)p->perm->len, p->perm->str);
+
     struct kittycat_string *ps = kittycat_string_new(finalPerm, len);
     ps->__isCloned = true; // We created a new string, so flag it as cloned
     return ps;
@@ -107,26 +188,31 @@ struct kittycat_string *kittycat_permission_to_str(struct KittycatPermission *p)
 
 void kittycat_permission_free(struct KittycatPermission *p)
 {
-    // Only call string_free if kittycat_new_permission_cloned was used
-    if (p->__isCloned)
+    // Interned strings belong to the interner and caller owned strings to the caller
+    if (p == NULL || p->__arena != NULL)
     {
-        kittycat_string_free(p->namespace);
-        kittycat_string_free(p->perm);
+        return; // Released together with its arena
     }
     __kittycat_free(p);
 }
 
 struct KittycatPermissionList *kittycat_permission_list_new()
 {
-    struct KittycatPermissionList *pl = __kittycat_malloc(sizeof(struct KittycatPermissionList));
-    pl->perms = __kittycat_malloc(sizeof(struct KittycatPermission *));
+    return kittycat_permission_list_new_in_arena(NULL);
+}
+
+struct KittycatPermissionList *kittycat_permission_list_new_in_arena(struct kittycat_arena *arena)
+{
+    struct KittycatPermissionList *pl = __kittycat_perms_alloc(arena, sizeof(struct KittycatPermissionList));
+    pl->perms = __kittycat_perms_alloc(arena, sizeof(struct KittycatPermission *));
     pl->len = 0;
+    pl->__arena = arena;
     return pl;
 }
 
 void kittycat_permission_list_add(struct KittycatPermissionList *pl, struct KittycatPermission *const perm)
 {
-    pl->perms = __kittycat_realloc(pl->perms, (pl->len + 1) * sizeof(struct KittycatPermission *));
+    pl->perms = __kittycat_perms_realloc(pl->__arena, pl->perms, (pl->len + 1) * sizeof(struct KittycatPermission *));
     pl->perms[pl->len] = perm;
     pl->len++;
 }
@@ -146,7 +232,7 @@ void kittycat_permission_list_rm(struct KittycatPermissionList *pl, size_t i)
     }
 
     pl->len--;
-    pl->perms = __kittycat_realloc(pl->perms, pl->len * sizeof(struct KittycatPermission *));
+    pl->perms = __kittycat_perms_realloc(pl->__arena, pl->perms, pl->len * sizeof(struct KittycatPermission *));
 }
 
 struct KittycatPermissionList *kittycat_permission_list_new_with_perms(
@@ -155,6 +241,7 @@ struct KittycatPermissionList *kittycat_permission_list_new_with_perms(
     struct KittycatPermissionList *pl = __kittycat_malloc(sizeof(struct KittycatPermissionList));
     pl->perms = __kittycat_malloc(len * sizeof(struct KittycatPermission *));
     pl->len = len;
+    pl->__arena = NULL;
     for (size_t i = 0; i < len; i++)
     {
         pl->perms[i] = perms[i];
@@ -162,6 +249,28 @@ struct KittycatPermissionList *kittycat_permission_list_new_with_perms(
     return pl;
 }
 
+struct KittycatPermissionList *kittycat_permission_list_new_from_buffer(const char *const buf, const size_t len, const char sep)
+{
+    struct KittycatPermissionList *pl = kittycat_permission_list_new();
+
+    size_t start = 0;
+    while (start < len)
+    {
+        const char *end_ptr = memchr(buf + start, sep, len - start);
+        size_t end = end_ptr == NULL ? len : (size_t)(end_ptr - buf);
+
+        struct KittycatPermissionView view;
+        if (kittycat_permission_view_parse(buf + start, end - start, &view))
+        {
+            kittycat_permission_list_add(pl, kittycat_permission_new_from_view(&view));
+        }
+
+        start = end + 1;
+    }
+
+    return pl;
+}
+
 struct kittycat_string *kittycat_permission_list_join(struct KittycatPermissionList *pl, char *sep)
 {
     struct kittycat_string *joined = kittycat_string_new("", 0);
@@ -202,7 +311,7 @@ bool kittycat_permission_lists_equal(struct KittycatPermissionList *pl1, struct
         struct KittycatPermission *p1 = pl1->perms[i];
         struct KittycatPermission *p2 = pl2->perms[i];
 
-        if (!kittycat_string_equal(p1->namespace, p2->namespace) || !kittycat_string_equal(p1->perm, p2->perm) || p1->negator != p2->negator)
+        if (p1->namespace_atom != p2->namespace_atom || p1->perm_atom != p2->perm_atom || p1->negator != p2->negator)
         {
             return false;
         }
@@ -226,15 +335,21 @@ void kittycat_permission_list_free(struct KittycatPermissionList *pl)
             pl->perms[i] = NULL;
         }
 
-        __kittycat_free(pl->perms);
-        pl->perms = NULL;
+        if (pl->__arena == NULL)
+        {
+            __kittycat_free(pl->perms);
+            pl->perms = NULL;
+        }
     }
 
-    __kittycat_free(pl);
+    if (pl->__arena == NULL)
+    {
+        __kittycat_free(pl);
+    }
     pl = NULL;
 }
 
-bool kittycat_has_perm(const struct KittycatPermissionList *const perms, const struct KittycatPermission *const perm)
+bool __kittycat_has_perm_atoms(const struct KittycatPermissionList *const perms, const uint32_t namespace_atom, const uint32_t perm_atom)
 {
     bool has_perm = false;
     bool has_negator = false;
@@ -244,22 +359,21 @@ bool kittycat_has_perm(const struct KittycatPermissionList *const perms, const s
         struct KittycatPermission *user_perm = perms->perms[i];
 
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
-        printf("perms: Namespace: %s, Perm: %s, Negator: %s\n", perm->namespace->str, perm->perm->str, perm->negator ? "true" : "false");
         printf("user_perms: Namespace: %s, Perm: %s, Negator: %s\n", user_perm->namespace->str, user_perm->perm->str, user_perm->negator ? "true" : "false");
 #endif
 
         // Special case of global.*
-        if (!user_perm->negator && kittycat_string_equal(user_perm->namespace, &__kittycat_perm_global_ns) && kittycat_string_equal(user_perm->perm, &__kittycat_perm_global_perm))
+        if (!user_perm->negator && user_perm->namespace_atom == KITTYCAT_ATOM_GLOBAL && user_perm->perm_atom == KITTYCAT_ATOM_WILDCARD)
         {
             return true;
         }
 
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
-        printf("NS = NS: %s, Perm = Perm: %s\n", kittycat_string_equal(user_perm->namespace, perm->namespace) ? "true" : "false", kittycat_string_equal(user_perm->perm, perm->perm) ? "true" : "false");
+        printf("NS = NS: %s, Perm = Perm: %s\n", user_perm->namespace_atom == namespace_atom ? "true" : "false", user_perm->perm_atom == perm_atom ? "true" : "false");
 #endif
 
-        if ((kittycat_string_equal(user_perm->namespace, perm->namespace) || kittycat_string_equal(user_perm->namespace, &__kittycat_perm_global_ns)) &&
-            (kittycat_string_equal(user_perm->perm, &__kittycat_perm_global_perm) || kittycat_string_equal(user_perm->perm, perm->perm)))
+        if ((user_perm->namespace_atom == namespace_atom || user_perm->namespace_atom == KITTYCAT_ATOM_GLOBAL) &&
+            (user_perm->perm_atom == KITTYCAT_ATOM_WILDCARD || user_perm->perm_atom == perm_atom))
         {
             // We have to check for negator
             has_perm = true;
@@ -274,6 +388,224 @@ bool kittycat_has_perm(const struct KittycatPermissionList *const perms, const s
     return has_perm && !has_negator;
 }
 
+bool kittycat_has_perm(const struct KittycatPermissionList *const perms, const struct KittycatPermission *const perm)
+{
+#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
+    printf("perms: Namespace: %s, Perm: %s, Negator: %s\n", perm->namespace->str, perm->perm->str, perm->negator ? "true" : "false");
+#endif
+
+    return __kittycat_has_perm_atoms(perms, perm->namespace_atom, perm->perm_atom);
+}
+
+bool kittycat_has_perm_cstr(const struct KittycatPermissionList *const perms, const char *const perm, const size_t len)
+{
+    const char *ns;
+    const char *p;
+    size_t ns_len;
+    size_t p_len;
+    bool negator;
+    __kittycat_permission_split(perm, len, &ns, &ns_len, &p, &p_len, &negator);
+
+    // A namespace or perm that was never interned can't be equal to the namespace or perm of any user permission,
+    // so KITTYCAT_ATOM_NONE (which matches nothing) is exactly right for it
+    uint32_t namespace_atom = ns == NULL ? KITTYCAT_ATOM_GLOBAL : kittycat_string_atom_lookup(ns, ns_len);
+    uint32_t perm_atom = kittycat_string_atom_lookup(p, p_len);
+
+    return __kittycat_has_perm_atoms(perms, namespace_atom, perm_atom);
+}
+
+// Returns if two (not necessarily NUL terminated) slices are equal
+bool __kittycat_slice_equal(const char *a, size_t a_len, const char *b, size_t b_len)
+{
+    return a_len == b_len && memcmp(a, b, a_len) == 0;
+}
+
+bool kittycat_has_perm_cstr_arr(const char *const *user_perms, const size_t *user_perm_lens, const size_t n, const char *const perm, const size_t len)
+{
+    const char *ns;
+    const char *p;
+    size_t ns_len;
+    size_t p_len;
+    bool negator;
+    __kittycat_permission_split(perm, len, &ns, &ns_len, &p, &p_len, &negator);
+
+    if (ns == NULL)
+    {
+        ns = "global";
+        ns_len = 6;
+    }
+
+    bool has_perm = false;
+    bool has_negator = false;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const char *user_ns;
+        const char *user_p;
+        size_t user_ns_len;
+        size_t user_p_len;
+        bool user_negator;
+        __kittycat_permission_split(user_perms[i], user_perm_lens != NULL ? user_perm_lens[i] : strlen(user_perms[i]), &user_ns, &user_ns_len, &user_p, &user_p_len, &user_negator);
+
+        bool user_global = user_ns == NULL || __kittycat_slice_equal(user_ns, user_ns_len, "global", 6);
+        bool user_wildcard = __kittycat_slice_equal(user_p, user_p_len, "*", 1);
+
+        // Special case of global.*
+        if (!user_negator && user_global && user_wildcard)
+        {
+            return true;
+        }
+
+        if ((user_global || __kittycat_slice_equal(user_ns, user_ns_len, ns, ns_len)) &&
+            (user_wildcard || __kittycat_slice_equal(user_p, user_p_len, p, p_len)))
+        {
+            // We have to check for negator
+            has_perm = true;
+
+            if (user_negator)
+            {
+                has_negator = true;
+            }
+        }
+    }
+
+    return has_perm && !has_negator;
+}
+
+/* Packed KittycatPermissions */
+
+uint64_t kittycat_permission_pack(const struct KittycatPermission *const p)
+{
+    return KITTYCAT_PACKED_PERMISSION(p->namespace_atom, p->perm_atom, p->negator);
+}
+
+struct KittycatPermission *kittycat_permission_unpack(const uint64_t packed)
+{
+    return __kittycat_new_permission_from_atoms(
+        KITTYCAT_PACKED_PERMISSION_NAMESPACE(packed),
+        KITTYCAT_PACKED_PERMISSION_PERM(packed),
+        KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(packed));
+}
+
+uint64_t kittycat_permission_pack_str(const char *const str, const size_t len)
+{
+    const char *ns;
+    const char *perm;
+    size_t ns_len;
+    size_t perm_len;
+    bool negator;
+    __kittycat_permission_split(str, len, &ns, &ns_len, &perm, &perm_len, &negator);
+
+    return KITTYCAT_PACKED_PERMISSION(
+        ns == NULL ? KITTYCAT_ATOM_GLOBAL : kittycat_string_intern(ns, ns_len),
+        kittycat_string_intern(perm, perm_len),
+        negator);
+}
+
+struct KittycatPackedPermissionList *__kittycat_packed_permission_list_with_cap(size_t cap)
+{
+    struct KittycatPackedPermissionList *ppl = __kittycat_malloc(sizeof(struct KittycatPackedPermissionList));
+    ppl->__cap = cap > 0 ? cap : 1;
+    ppl->perms = __kittycat_malloc(ppl->__cap * sizeof(uint64_t));
+    ppl->len = 0;
+    return ppl;
+}
+
+struct KittycatPackedPermissionList *kittycat_packed_permission_list_new()
+{
+    return __kittycat_packed_permission_list_with_cap(4);
+}
+
+void kittycat_packed_permission_list_add(struct KittycatPackedPermissionList *ppl, const uint64_t perm)
+{
+    if (ppl->len == ppl->__cap)
+    {
+        ppl->__cap *= 2;
+        ppl->perms = __kittycat_realloc(ppl->perms, ppl->__cap * sizeof(uint64_t));
+    }
+
+    ppl->perms[ppl->len] = perm;
+    ppl->len++;
+}
+
+struct KittycatPackedPermissionList *kittycat_permission_list_pack(const struct KittycatPermissionList *const pl)
+{
+    struct KittycatPackedPermissionList *ppl = __kittycat_packed_permission_list_with_cap(pl->len);
+
+    for (size_t i = 0; i < pl->len; i++)
+    {
+        ppl->perms[i] = kittycat_permission_pack(pl->perms[i]);
+    }
+    ppl->len = pl->len;
+
+    return ppl;
+}
+
+struct KittycatPermissionList *kittycat_packed_permission_list_unpack(const struct KittycatPackedPermissionList *const ppl)
+{
+    struct KittycatPermissionList *pl = __kittycat_malloc(sizeof(struct KittycatPermissionList));
+    pl->perms = __kittycat_malloc((ppl->len > 0 ? ppl->len : 1) * sizeof(struct KittycatPermission *));
+    pl->len = ppl->len;
+    pl->__arena = NULL;
+
+    for (size_t i = 0; i < ppl->len; i++)
+    {
+        pl->perms[i] = kittycat_permission_unpack(ppl->perms[i]);
+    }
+
+    return pl;
+}
+
+void kittycat_packed_permission_list_free(struct KittycatPackedPermissionList *ppl)
+{
+    if (ppl == NULL)
+    {
+        return;
+    }
+
+    __kittycat_free(ppl->perms);
+    __kittycat_free(ppl);
+}
+
+bool __kittycat_has_perm_packed(const uint64_t *const perms, const size_t len, const uint32_t namespace_atom, const uint32_t perm_atom)
+{
+    const uint64_t global_star = KITTYCAT_PACKED_PERMISSION(KITTYCAT_ATOM_GLOBAL, KITTYCAT_ATOM_WILDCARD, false);
+    bool has_perm = false;
+    bool has_negator = false;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        uint64_t user_perm = perms[i];
+
+        // Special case of global.*
+        if (user_perm == global_star)
+        {
+            return true;
+        }
+
+        uint32_t user_ns = KITTYCAT_PACKED_PERMISSION_NAMESPACE(user_perm);
+        uint32_t user_p = KITTYCAT_PACKED_PERMISSION_PERM(user_perm);
+
+        if ((user_ns == namespace_atom || user_ns == KITTYCAT_ATOM_GLOBAL) && (user_p == KITTYCAT_ATOM_WILDCARD || user_p == perm_atom))
+        {
+            // We have to check for negator
+            has_perm = true;
+
+            if (KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(user_perm))
+            {
+                has_negator = true;
+            }
+        }
+    }
+
+    return has_perm && !has_negator;
+}
+
+bool kittycat_packed_has_perm(const struct KittycatPackedPermissionList *const perms, const uint64_t perm)
+{
+    return __kittycat_has_perm_packed(perms->perms, perms->len, KITTYCAT_PACKED_PERMISSION_NAMESPACE(perm), KITTYCAT_PACKED_PERMISSION_PERM(perm));
+}
+
 /* KittycatPermission resolution */
 
 struct KittycatPartialStaffPosition *kittycat_partial_staff_position_new(char *id, int32_t index, struct KittycatPermissionList *perms)
@@ -282,13 +614,15 @@ struct KittycatPartialStaffPosition *kittycat_partial_staff_position_new(char *i
     p->id = kittycat_string_new(id, strlen(id));
     p->index = index;
     p->perms = perms;
+    p->__shared = false;
+    p->__kinds = NULL;
     return p;
 }
 
 void kittycat_partial_staff_position_free(struct KittycatPartialStaffPosition *p)
 {
-    // Already freed if NULL
-    if (p == NULL)
+    // Already freed if NULL. Shared positions belong to their kittycat_position_registry
+    if (p == NULL || p->__shared)
     {
         return;
     }
@@ -376,149 +710,312 @@ void kittycat_staff_permissions_free(struct StaffKittycatPermissions *sp)
     sp = NULL;
 }
 
-// Internally used for clearing KittycatPermissions
-struct __KittycatToRemoveArr
-{
-    size_t *arr;
-    size_t len;
-};
-
-struct __KittycatToRemoveArr *__kittycat_toRemove_arr_new()
-{
-    struct __KittycatToRemoveArr *ia = __kittycat_malloc(sizeof(struct __KittycatToRemoveArr));
-    ia->arr = __kittycat_malloc(sizeof(int32_t));
-    ia->len = 0;
-    return ia;
-}
+// Marks the end of a slot list in a __KittycatOrderedPermissionMap
+#define __KITTYCAT_SLOT_NONE ((size_t)-1)
 
-void __kittycat_toRemove_arr_add(struct __KittycatToRemoveArr *ia, size_t i)
+// A slot of the insertion ordered array of a __KittycatOrderedPermissionMap
+//
+// Besides the insertion order, every live slot is linked into the list of slots of its namespace and,
+// if it holds a negator, into the list of negators of its namespace
+struct __KittycatOrderedPermissionSlot
 {
-    ia->arr = __kittycat_realloc(ia->arr, (ia->len + 1) * sizeof(size_t));
-    ia->arr[ia->len] = i;
-    ia->len++;
-}
+    // NULL if the slot is a tombstone
+    struct KittycatPermission *perm;
+    size_t ns_prev;
+    size_t ns_next;
+    size_t neg_prev;
+    size_t neg_next;
+};
 
-void __kittycat_toRemove_arr_free(struct __KittycatToRemoveArr *ia)
+// The slots of one namespace in a __KittycatOrderedPermissionMap
+struct __KittycatNamespaceBucket
 {
-    __kittycat_free(ia->arr);
-    __kittycat_free(ia);
-}
+    uint32_t namespace_atom;
+    size_t head;
+    size_t tail;
+    size_t neg_head;
+    size_t neg_tail;
+};
 
-// A kittycat_hashmap of KittycatPermissions that are ordered
+// A kittycat_hashmap of KittycatPermissions that are ordered by insertion and grouped by namespace
+//
+// `slots` holds the KittycatPermissions in insertion order. Deleting a KittycatPermission leaves a tombstone in its slot
+// (whose index is stored in the kittycat_hashmap entry) so deletes are O(1). Tombstones are compacted away when appending
+// to a full `slots` array. The per namespace lists in `buckets` let a namespace be cleared, or its negators be dropped,
+// in time proportional to the number of KittycatPermissions in that namespace
 //
 // Note that this struct is *unstable* and has ZERO API stability guarantees
 struct __KittycatOrderedPermissionMap
 {
     struct kittycat_hashmap *map;
-    struct KittycatPermission **order;
+    // Namespace atom -> __KittycatNamespaceBucket
+    struct kittycat_hashmap *buckets;
+    // Insertion ordered slots
+    struct __KittycatOrderedPermissionSlot *slots;
+    // Number of slots used in `slots`, including tombstones
+    size_t order_len;
+    // Number of live KittycatPermissions in the map
     size_t len;
+
+    // Internal
+    size_t __order_cap;
 };
 
-uint64_t __kittycat_permission_hash(const void *item, uint64_t seed0, uint64_t seed1)
+// An entry in the kittycat_hashmap of a __KittycatOrderedPermissionMap
+struct __KittycatOrderedPermissionEntry
 {
-    const struct KittycatPermission *pc = item;
-    struct KittycatPermission *p = (struct KittycatPermission *)pc;
-    struct kittycat_string *perm_str = kittycat_permission_to_str(p);
-#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
-    printf("__KittycatPermissionwc_hash: Hashing KittycatPermission %s\n", perm_str->str);
-#endif
-    uint64_t hash = kittycat_hashmap_sip(perm_str->str, perm_str->len, seed0, seed1);
-    kittycat_string_free(perm_str);
-    return hash;
-}
+    // The packed form of the KittycatPermission, see `kittycat_permission_pack`
+    uint64_t key;
+    // The slot of the KittycatPermission in `slots`
+    size_t slot;
+};
 
-int __kittycat_permission_compare(const void *a, const void *b, void *udata)
+uint64_t __kittycat_ordered_permission_entry_hash(const void *item, uint64_t seed0, uint64_t seed1)
 {
-    const struct KittycatPermission *pac = a;
-    const struct KittycatPermission *pbc = b;
-    struct KittycatPermission *pa = (struct KittycatPermission *)pac;
-    struct KittycatPermission *pb = (struct KittycatPermission *)pbc;
-
-    struct kittycat_string *pa_str = kittycat_permission_to_str(pa);
-    struct kittycat_string *pb_str = kittycat_permission_to_str(pb);
-
-    bool cmp = kittycat_string_equal(pa_str, pb_str);
+    const struct __KittycatOrderedPermissionEntry *e = item;
+    return kittycat_hashmap_xxhash3(&e->key, sizeof(uint64_t), seed0, seed1);
+}
 
-#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
-    printf("__kittycat_ordered_permission_compare: Comparing %s and %s: %d\n", pa_str->str, pb_str->str, cmp);
-#endif
+int __kittycat_ordered_permission_entry_compare(const void *a, const void *b, void *udata)
+{
+    const struct __KittycatOrderedPermissionEntry *ea = a;
+    const struct __KittycatOrderedPermissionEntry *eb = b;
+    return ea->key == eb->key ? 0 : 1;
+}
 
-    kittycat_string_free(pa_str);
-    kittycat_string_free(pb_str);
+uint64_t __kittycat_namespace_bucket_hash(const void *item, uint64_t seed0, uint64_t seed1)
+{
+    const struct __KittycatNamespaceBucket *nb = item;
+    return kittycat_hashmap_xxhash3(&nb->namespace_atom, sizeof(uint32_t), seed0, seed1);
+}
 
-    return cmp ? 0 : 1;
+int __kittycat_namespace_bucket_compare(const void *a, const void *b, void *udata)
+{
+    const struct __KittycatNamespaceBucket *na = a;
+    const struct __KittycatNamespaceBucket *nb = b;
+    return na->namespace_atom == nb->namespace_atom ? 0 : 1;
 }
 
 struct __KittycatOrderedPermissionMap *__kittycat_ordered_permission_map_new()
 {
     struct __KittycatOrderedPermissionMap *opm = __kittycat_malloc(sizeof(struct __KittycatOrderedPermissionMap));
-    opm->map = kittycat_hashmap_new(sizeof(struct KittycatPermission), 0, 0, 0, __kittycat_permission_hash, __kittycat_permission_compare, NULL, NULL);
-    opm->order = __kittycat_malloc(sizeof(struct KittycatPermission *));
+    opm->map = kittycat_hashmap_new(sizeof(struct __KittycatOrderedPermissionEntry), 0, 0, 0, __kittycat_ordered_permission_entry_hash, __kittycat_ordered_permission_entry_compare, NULL, NULL);
+    opm->buckets = kittycat_hashmap_new(sizeof(struct __KittycatNamespaceBucket), 0, 0, 0, __kittycat_namespace_bucket_hash, __kittycat_namespace_bucket_compare, NULL, NULL);
+    opm->__order_cap = 8;
+    opm->slots = __kittycat_malloc(opm->__order_cap * sizeof(struct __KittycatOrderedPermissionSlot));
+    opm->order_len = 0;
     opm->len = 0;
     return opm;
 }
 
-struct KittycatPermission *__kittycat_ordered_permission_map_get(struct __KittycatOrderedPermissionMap *opm, struct KittycatPermission *perm)
+// Returns the bucket of `namespace_atom`. If it does not exist yet, it is created if `create` is set, otherwise NULL is returned
+//
+// The returned pointer is only valid until the next bucket is created
+struct __KittycatNamespaceBucket *__kittycat_ordered_permission_map_bucket(struct __KittycatOrderedPermissionMap *opm, uint32_t namespace_atom, bool create)
 {
-#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
-    struct kittycat_string *perm_str = kittycat_permission_to_str(perm);
-    printf("__kittycat_ordered_permission_map_get: Getting KittycatPermission %s\n", perm_str->str);
-    kittycat_string_free(perm_str);
-#endif
-
-    const void *pwc_void = kittycat_hashmap_get(opm->map, perm);
-    if (pwc_void == NULL)
+    struct __KittycatNamespaceBucket probe = {namespace_atom, __KITTYCAT_SLOT_NONE, __KITTYCAT_SLOT_NONE, __KITTYCAT_SLOT_NONE, __KITTYCAT_SLOT_NONE};
+    const struct __KittycatNamespaceBucket *nb = kittycat_hashmap_get(opm->buckets, &probe);
+    if (nb == NULL && create)
     {
-        return NULL;
+        kittycat_hashmap_set(opm->buckets, &probe);
+        nb = kittycat_hashmap_get(opm->buckets, &probe);
     }
-    struct KittycatPermission *pwc = (struct KittycatPermission *)pwc_void;
-    return pwc;
+    return (struct __KittycatNamespaceBucket *)nb;
 }
 
-// Deletes the KittycatPermission from the ordered KittycatPermission map
-struct KittycatPermission *__kittycat_ordered_permission_map_del(struct __KittycatOrderedPermissionMap *opm, struct KittycatPermission *perm)
+// Links slot `i` at the end of the lists of its namespace
+void __kittycat_ordered_permission_map_link(struct __KittycatOrderedPermissionMap *opm, size_t i)
 {
-#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
-    struct kittycat_string *perm_str = kittycat_permission_to_str(perm);
-    printf("__kittycat_ordered_permission_map_del: Deleting KittycatPermission %s\n", perm_str->str);
-    kittycat_string_free(perm_str);
-#endif
+    struct __KittycatOrderedPermissionSlot *slot = &opm->slots[i];
+    struct __KittycatNamespaceBucket *nb = __kittycat_ordered_permission_map_bucket(opm, slot->perm->namespace_atom, true);
 
-    const void *pwc_void = kittycat_hashmap_delete(opm->map, perm);
-
-    if (pwc_void == NULL)
+    slot->ns_prev = nb->tail;
+    slot->ns_next = __KITTYCAT_SLOT_NONE;
+    if (nb->tail != __KITTYCAT_SLOT_NONE)
     {
-        // Nothing was deleted
-        return NULL;
+        opm->slots[nb->tail].ns_next = i;
     }
-
-    struct KittycatPermission *pwc = (struct KittycatPermission *)pwc_void;
-
-    // Find the index of the KittycatPermission in the order
-    size_t index = 0;
-
-    for (size_t i = 0; i < opm->len; i++)
+    else
     {
-        if (kittycat_hashmap_get(opm->map, opm->order[i]) == NULL)
-        {
-            index = i;
-            break;
-        }
+        nb->head = i;
     }
+    nb->tail = i;
 
-    // Remove the KittycatPermission from the order
-    for (size_t i = index; i < opm->len - 1; i++)
+    slot->neg_prev = __KITTYCAT_SLOT_NONE;
+    slot->neg_next = __KITTYCAT_SLOT_NONE;
+    if (slot->perm->negator)
     {
-        opm->order[i] = opm->order[i + 1];
+        slot->neg_prev = nb->neg_tail;
+        if (nb->neg_tail != __KITTYCAT_SLOT_NONE)
+        {
+            opm->slots[nb->neg_tail].neg_next = i;
+        }
+        else
+        {
+            nb->neg_head = i;
+        }
+        nb->neg_tail = i;
     }
-
-    // Now set length correctly, as we have removed needed element
-    opm->len = kittycat_hashmap_count(opm->map);
-
-    return pwc;
 }
 
-void __kittycat_ordered_permission_map_free(struct __KittycatOrderedPermissionMap *opm)
+// Unlinks slot `i` from the lists of its namespace
+void __kittycat_ordered_permission_map_unlink(struct __KittycatOrderedPermissionMap *opm, struct __KittycatNamespaceBucket *nb, size_t i)
+{
+    struct __KittycatOrderedPermissionSlot *slot = &opm->slots[i];
+
+    if (slot->ns_prev != __KITTYCAT_SLOT_NONE)
+    {
+        opm->slots[slot->ns_prev].ns_next = slot->ns_next;
+    }
+    else
+    {
+        nb->head = slot->ns_next;
+    }
+    if (slot->ns_next != __KITTYCAT_SLOT_NONE)
+    {
+        opm->slots[slot->ns_next].ns_prev = slot->ns_prev;
+    }
+    else
+    {
+        nb->tail = slot->ns_prev;
+    }
+
+    if (slot->perm->negator)
+    {
+        if (slot->neg_prev != __KITTYCAT_SLOT_NONE)
+        {
+            opm->slots[slot->neg_prev].neg_next = slot->neg_next;
+        }
+        else
+        {
+            nb->neg_head = slot->neg_next;
+        }
+        if (slot->neg_next != __KITTYCAT_SLOT_NONE)
+        {
+            opm->slots[slot->neg_next].neg_prev = slot->neg_prev;
+        }
+        else
+        {
+            nb->neg_tail = slot->neg_prev;
+        }
+    }
+}
+
+// Removes the KittycatPermission in slot `i` from the kittycat_hashmap and leaves a tombstone. Does not touch the namespace lists
+void __kittycat_ordered_permission_map_tombstone(struct __KittycatOrderedPermissionMap *opm, size_t i)
+{
+    struct __KittycatOrderedPermissionEntry probe = {kittycat_permission_pack(opm->slots[i].perm), 0};
+    kittycat_hashmap_delete(opm->map, &probe);
+    opm->slots[i].perm = NULL;
+    opm->len--;
+}
+
+struct KittycatPermission *__kittycat_ordered_permission_map_get(struct __KittycatOrderedPermissionMap *opm, struct KittycatPermission *perm)
+{
+#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
+    struct kittycat_string *perm_str = kittycat_permission_to_str(perm);
+    printf("__kittycat_ordered_permission_map_get: Getting KittycatPermission %s\n", perm_str->str);
+    kittycat_string_free(perm_str);
+#endif
+
+    struct __KittycatOrderedPermissionEntry probe = {kittycat_permission_pack(perm), 0};
+    const struct __KittycatOrderedPermissionEntry *e = kittycat_hashmap_get(opm->map, &probe);
+    if (e == NULL)
+    {
+        return NULL;
+    }
+    return opm->slots[e->slot].perm;
+}
+
+// Deletes the KittycatPermission from the ordered KittycatPermission map, leaving a tombstone in its slot
+struct KittycatPermission *__kittycat_ordered_permission_map_del(struct __KittycatOrderedPermissionMap *opm, struct KittycatPermission *perm)
+{
+#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
+    struct kittycat_string *perm_str = kittycat_permission_to_str(perm);
+    printf("__kittycat_ordered_permission_map_del: Deleting KittycatPermission %s\n", perm_str->str);
+    kittycat_string_free(perm_str);
+#endif
+
+    struct __KittycatOrderedPermissionEntry probe = {kittycat_permission_pack(perm), 0};
+    const struct __KittycatOrderedPermissionEntry *e = kittycat_hashmap_delete(opm->map, &probe);
+
+    if (e == NULL)
+    {
+        // Nothing was deleted
+        return NULL;
+    }
+
+    size_t i = e->slot;
+    struct KittycatPermission *pwc = opm->slots[i].perm;
+    __kittycat_ordered_permission_map_unlink(opm, __kittycat_ordered_permission_map_bucket(opm, pwc->namespace_atom, false), i);
+    opm->slots[i].perm = NULL;
+    opm->len--;
+
+    return pwc;
+}
+
+// Deletes every KittycatPermission in the namespace `namespace_atom`
+void __kittycat_ordered_permission_map_clear_namespace(struct __KittycatOrderedPermissionMap *opm, uint32_t namespace_atom)
+{
+    struct __KittycatNamespaceBucket *nb = __kittycat_ordered_permission_map_bucket(opm, namespace_atom, false);
+    if (nb == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = nb->head; i != __KITTYCAT_SLOT_NONE; i = opm->slots[i].ns_next)
+    {
+        __kittycat_ordered_permission_map_tombstone(opm, i);
+    }
+
+    nb->head = nb->tail = nb->neg_head = nb->neg_tail = __KITTYCAT_SLOT_NONE;
+}
+
+// Deletes every negator in the namespace `namespace_atom`
+void __kittycat_ordered_permission_map_clear_negators(struct __KittycatOrderedPermissionMap *opm, uint32_t namespace_atom)
+{
+    struct __KittycatNamespaceBucket *nb = __kittycat_ordered_permission_map_bucket(opm, namespace_atom, false);
+    if (nb == NULL)
+    {
+        return;
+    }
+
+    size_t i = nb->neg_head;
+    while (i != __KITTYCAT_SLOT_NONE)
+    {
+        size_t next = opm->slots[i].neg_next;
+        __kittycat_ordered_permission_map_unlink(opm, nb, i);
+        __kittycat_ordered_permission_map_tombstone(opm, i);
+        i = next;
+    }
+}
+
+// Removes all tombstones from `slots`, updating the slots stored in the kittycat_hashmap and relinking the namespace lists
+void __kittycat_ordered_permission_map_compact(struct __KittycatOrderedPermissionMap *opm)
+{
+    kittycat_hashmap_clear(opm->buckets, true);
+
+    size_t j = 0;
+    for (size_t i = 0; i < opm->order_len; i++)
+    {
+        if (opm->slots[i].perm == NULL)
+        {
+            continue;
+        }
+
+        if (i != j)
+        {
+            struct __KittycatOrderedPermissionEntry entry = {kittycat_permission_pack(opm->slots[i].perm), j};
+            kittycat_hashmap_set(opm->map, &entry);
+            opm->slots[j].perm = opm->slots[i].perm;
+        }
+        __kittycat_ordered_permission_map_link(opm, j);
+        j++;
+    }
+    opm->order_len = j;
+}
+
+void __kittycat_ordered_permission_map_free(struct __KittycatOrderedPermissionMap *opm)
 {
     // Already freed if NULL
     if (opm == NULL)
@@ -527,7 +1024,8 @@ void __kittycat_ordered_permission_map_free(struct __KittycatOrderedPermissionMa
     }
 
     kittycat_hashmap_free(opm->map);
-    __kittycat_free(opm->order);
+    kittycat_hashmap_free(opm->buckets);
+    __kittycat_free(opm->slots);
     __kittycat_free(opm);
     opm = NULL;
 }
@@ -535,26 +1033,22 @@ void __kittycat_ordered_permission_map_free(struct __KittycatOrderedPermissionMa
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
 void __kittycat_ordered_permission_map_printf_dbg(struct __KittycatOrderedPermissionMap *opm)
 {
-    for (size_t i = 0; i < opm->len; i++)
+    for (size_t i = 0; i < opm->order_len; i++)
     {
-        struct KittycatPermission *perm = opm->order[i];
+        struct KittycatPermission *perm = opm->slots[i].perm;
+        if (perm == NULL)
+        {
+            printf("order iter: <tombstone>\n");
+            continue;
+        }
         struct kittycat_string *perm_str = kittycat_permission_to_str(perm);
         printf("order iter: %s\n", perm_str->str);
         kittycat_string_free(perm_str);
     }
-
-    void *item;
-    size_t i = 0;
-    while (kittycat_hashmap_iter(opm->map, &i, &item))
-    {
-        struct KittycatPermission *perm = item;
-        struct kittycat_string *perm_str = kittycat_permission_to_str(perm);
-        printf("applied perm: %s\n", perm_str->str);
-        kittycat_string_free(perm_str);
-    }
 }
 #endif
 
+// Appends a KittycatPermission to the ordered KittycatPermission map. The KittycatPermission must not already be in the map
 void __kittycat_ordered_permission_map_set(struct __KittycatOrderedPermissionMap *opm, struct KittycatPermission *p)
 {
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
@@ -563,59 +1057,172 @@ void __kittycat_ordered_permission_map_set(struct __KittycatOrderedPermissionMap
     kittycat_string_free(perm_str);
 #endif
 
-    kittycat_hashmap_set(opm->map, p);
-    opm->len = kittycat_hashmap_count(opm->map);
-    opm->order = __kittycat_realloc(opm->order, (opm->len * sizeof(struct KittycatPermission *)));
-    opm->order[opm->len - 1] = p;
+    if (opm->order_len == opm->__order_cap)
+    {
+        // Only grow if compacting would not free up at least half of the slots, so appends stay amortized O(1)
+        if (opm->len * 2 > opm->__order_cap)
+        {
+            opm->__order_cap *= 2;
+            opm->slots = __kittycat_realloc(opm->slots, opm->__order_cap * sizeof(struct __KittycatOrderedPermissionSlot));
+        }
+        __kittycat_ordered_permission_map_compact(opm);
+    }
 
-#if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
-    struct kittycat_string *perm_str = kittycat_permission_to_str(p);
-    printf(" __kittycat_ordered_permission_map_set: Successfully set KittycatPermission %s\n", perm_str->str);
-    kittycat_string_free(perm_str);
-#endif
+    size_t i = opm->order_len;
+    struct __KittycatOrderedPermissionEntry entry = {kittycat_permission_pack(p), i};
+    kittycat_hashmap_set(opm->map, &entry);
+    opm->slots[i].perm = p;
+    __kittycat_ordered_permission_map_link(opm, i);
+    opm->order_len++;
+    opm->len++;
 
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
     __kittycat_ordered_permission_map_printf_dbg(opm);
 #endif
 }
 
+// Deletes every KittycatPermission in the map at once. The map keeps its capacity, so refilling it does not allocate
 void __kittycat_ordered_permission_map_clear(struct __KittycatOrderedPermissionMap *opm)
 {
-    kittycat_hashmap_clear(opm->map, false);
+    kittycat_hashmap_clear(opm->map, true);
+    kittycat_hashmap_clear(opm->buckets, true);
+    opm->order_len = 0;
     opm->len = 0;
-    __kittycat_free(opm->order);
-    opm->order = __kittycat_malloc(sizeof(struct KittycatPermission *));
 }
 
-struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct StaffKittycatPermissions *const sp)
+// Returns a KittycatPermission that is only used to look up `namespace_atom.perm_atom` in a kittycat_hashmap and therefore lives on the stack
+struct KittycatPermission __kittycat_permission_probe(uint32_t namespace_atom, uint32_t perm_atom, bool negator)
 {
-    struct __KittycatOrderedPermissionMap *opm = __kittycat_ordered_permission_map_new();
-    struct KittycatPartialStaffPositionList *userPositions = kittycat_partial_staff_position_list_new();
+    struct KittycatPermission p;
+    p.namespace = kittycat_string_atom_str(namespace_atom);
+    p.perm = kittycat_string_atom_str(perm_atom);
+    p.negator = negator;
+    p.namespace_atom = namespace_atom;
+    p.perm_atom = perm_atom;
+    p.ownership = KITTYCAT_PERMISSION_OWNERSHIP_INTERNED;
+    p.__arena = NULL;
+    return p;
+}
 
-    for (size_t i = 0; i < sp->user_positions->len; i++)
+// Stable merge sort of `n` positions by index in descending order. `tmp` must have room for `n` positions
+void __kittycat_partial_staff_positions_sort(struct KittycatPartialStaffPosition **positions, struct KittycatPartialStaffPosition **tmp, size_t n)
+{
+    // Insertion sort small runs first as most staff members only hold a handful of positions
+    const size_t run = 8;
+    for (size_t start = 0; start < n; start += run)
     {
-        struct KittycatPartialStaffPosition *pos = sp->user_positions->positions[i];
-        kittycat_partial_staff_position_list_add(userPositions, pos);
+        size_t end = start + run < n ? start + run : n;
+        for (size_t i = start + 1; i < end; i++)
+        {
+            struct KittycatPartialStaffPosition *pos = positions[i];
+            size_t j = i;
+            while (j > start && positions[j - 1]->index < pos->index)
+            {
+                positions[j] = positions[j - 1];
+                j--;
+            }
+            positions[j] = pos;
+        }
     }
 
-    // Add the KittycatPermission overrides as index 0
-    struct KittycatPartialStaffPosition *permOverrides = kittycat_partial_staff_position_new("perm_overrides", 0, sp->perm_overrides);
-    kittycat_partial_staff_position_list_add(userPositions, permOverrides);
+    // Then merge the runs bottom up, taking from the left run on ties to keep the sort stable
+    struct KittycatPartialStaffPosition **src = positions;
+    struct KittycatPartialStaffPosition **dst = tmp;
+    for (size_t width = run; width < n; width *= 2)
+    {
+        for (size_t lo = 0; lo < n; lo += 2 * width)
+        {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi)
+            {
+                dst[k++] = src[i]->index >= src[j]->index ? src[i++] : src[j++];
+            }
+            while (i < mid)
+            {
+                dst[k++] = src[i++];
+            }
+            while (j < hi)
+            {
+                dst[k++] = src[j++];
+            }
+        }
 
-    // Sort the positions by index in descending order
-    for (size_t i = 0; i < userPositions->len; i++)
+        struct KittycatPartialStaffPosition **swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != positions)
+    {
+        memcpy(positions, src, n * sizeof(struct KittycatPartialStaffPosition *));
+    }
+}
+
+// The id of the pseudo-position holding the perm overrides of a staff member
+static struct kittycat_string __kittycat_perm_overrides_id = {"perm_overrides", 14, false, NULL};
+
+struct KittycatPartialStaffPosition __kittycat_perm_overrides_position(const struct StaffKittycatPermissions *const sp)
+{
+    return (struct KittycatPartialStaffPosition){&__kittycat_perm_overrides_id, 0, sp->perm_overrides, false, NULL};
+}
+
+void __kittycat_staff_permissions_order_positions(const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena, const uint32_t flags, struct KittycatPartialStaffPosition *permOverridesPos, struct KittycatPartialStaffPositionList *out)
+{
+    // The positions are only borrowed from `sp`, so only the arrays holding them need to be allocated. The second half is scratch space for sorting
+    struct KittycatPartialStaffPosition **positions = __kittycat_perms_alloc(arena, 2 * (sp->user_positions->len + 1) * sizeof(struct KittycatPartialStaffPosition *));
+    __kittycat_staff_permissions_order_positions_into(sp, flags, permOverridesPos, positions, out);
+}
+
+void __kittycat_staff_permissions_order_positions_into(const struct StaffKittycatPermissions *const sp, const uint32_t flags, struct KittycatPartialStaffPosition *permOverridesPos, struct KittycatPartialStaffPosition **positions, struct KittycatPartialStaffPositionList *out)
+{
+    size_t n = sp->user_positions->len;
+    out->positions = positions;
+
+    // Sort the positions by index in descending order, unless they already are
+    bool sorted = true;
+    if (!(flags & KITTYCAT_RESOLVE_FLAGS_PRESORTED))
     {
-        for (size_t j = i + 1; j < userPositions->len; j++)
+        for (size_t i = 1; i < n; i++)
         {
-            if (userPositions->positions[i]->index < userPositions->positions[j]->index)
+            if (sp->user_positions->positions[i - 1]->index < sp->user_positions->positions[i]->index)
             {
-                struct KittycatPartialStaffPosition *temp = userPositions->positions[i];
-                userPositions->positions[i] = userPositions->positions[j];
-                userPositions->positions[j] = temp;
+                sorted = false;
+                break;
             }
         }
     }
 
+    memcpy(out->positions, sp->user_positions->positions, n * sizeof(struct KittycatPartialStaffPosition *));
+    if (!sorted)
+    {
+        __kittycat_partial_staff_positions_sort(out->positions, out->positions + n + 1, n);
+    }
+
+    // Add the KittycatPermission overrides as index 0, after every other position with an index >= 0
+    size_t at = n;
+    while (at > 0 && out->positions[at - 1]->index < 0)
+    {
+        out->positions[at] = out->positions[at - 1];
+        at--;
+    }
+    out->positions[at] = permOverridesPos;
+    out->len = n + 1;
+}
+
+// Resolves ordered positions by applying every KittycatPermission from the lowest to the highest precedence
+struct KittycatPermissionList *__kittycat_staff_permissions_resolve_forward(const struct KittycatPartialStaffPositionList *const userPositions, struct kittycat_arena *arena)
+{
+    struct __KittycatOrderedPermissionMap *opm = __kittycat_ordered_permission_map_new();
+    struct KittycatPermissionList *appliedPerms = __kittycat_staff_permissions_resolve_forward_with(opm, userPositions, arena);
+    __kittycat_ordered_permission_map_free(opm);
+    return appliedPerms;
+}
+
+// Applies ordered positions from the lowest to the highest precedence, leaving the resolved KittycatPermissions in `opm`
+void __kittycat_staff_permissions_apply_forward(struct __KittycatOrderedPermissionMap *opm, const struct KittycatPartialStaffPositionList *const userPositions)
+{
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_POSITION_LIST)
     // Send list of positions
     for (size_t i = 0; i < userPositions->len; i++)
@@ -633,9 +1240,10 @@ struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct S
         for (size_t j = 0; j < pos->perms->len; j++)
         {
             struct KittycatPermission *perm = pos->perms->perms[j];
-            if (kittycat_string_equal(perm->perm, &__kittycat_perm_clear_perm))
+            uint8_t kind = pos->__kinds != NULL ? pos->__kinds[j] : __kittycat_permission_classify(perm);
+            if (kind & __KITTYCAT_ENTRY_CLEAR)
             {
-                if (kittycat_string_equal(perm->namespace, &__kittycat_perm_global_ns))
+                if (kind & __KITTYCAT_ENTRY_GLOBAL_CLEAR)
                 {
                     // Clear all KittycatPermissions
                     __kittycat_ordered_permission_map_clear(opm);
@@ -643,31 +1251,17 @@ struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct S
                 else
                 {
                     // Clear all perms with this namespace
-                    struct __KittycatToRemoveArr *toRemove = __kittycat_toRemove_arr_new();
-                    for (size_t k = 0; k < opm->len; k++)
-                    {
-                        struct KittycatPermission *key = opm->order[k];
-                        if (kittycat_string_equal(key->namespace, perm->namespace))
-                        {
-                            __kittycat_toRemove_arr_add(toRemove, k);
-                        }
-                    }
-
-                    for (size_t k = 0; k < toRemove->len; k++)
-                    {
-                        __kittycat_ordered_permission_map_del(opm, opm->order[toRemove->arr[k]]);
-                    }
-
-                    __kittycat_toRemove_arr_free(toRemove);
+                    __kittycat_ordered_permission_map_clear_namespace(opm, perm->namespace_atom);
                 }
 
                 continue;
             }
 
-            if (perm->negator)
+            if (kind & __KITTYCAT_ENTRY_NEGATOR)
             {
                 // Check what gave the KittycatPermission. We *know* its sorted so we don't need to do anything but remove if it exists
-                struct KittycatPermission *nonNegated = kittycat_new_permission(perm->namespace, perm->perm, false);
+                struct KittycatPermission nonNegatedProbe = __kittycat_permission_probe(perm->namespace_atom, perm->perm_atom, false);
+                struct KittycatPermission *nonNegated = &nonNegatedProbe;
                 struct KittycatPermission *pwc = __kittycat_ordered_permission_map_get(opm, nonNegated);
                 if (pwc != NULL)
                 {
@@ -683,45 +1277,24 @@ struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct S
                     if (pwc != NULL)
                     {
                         // Case 3: The negator is already applied, so we can ignore it
-                        kittycat_permission_free(nonNegated);
                         continue;
                     }
 
                     // Then we can freely add the negator
                     __kittycat_ordered_permission_map_set(opm, perm);
                 }
-
-                kittycat_permission_free(nonNegated);
             }
             else
             {
                 // Special case: If a * element exists for a smaller index, then the negator must be ignored. E.g. manager has ~rpc.PremiumAdd but head_manager has no such negator
-                if (kittycat_string_equal(perm->perm, &__kittycat_perm_global_perm))
+                if (kind & __KITTYCAT_ENTRY_WILDCARD)
                 {
                     // Remove negators. As the KittycatPermissions are sorted, we can just check if a negator is in the kittycat_hashmap
-                    struct __KittycatToRemoveArr *toRemove = __kittycat_toRemove_arr_new();
-                    for (size_t k = 0; k < opm->len; k++)
-                    {
-                        struct KittycatPermission *key = opm->order[k];
-                        if (!(key->negator))
-                        {
-                            continue; // This special case only applies to negators
-                        }
-                        if (kittycat_string_equal(key->namespace, perm->namespace))
-                        {
-                            // Then we can ignore this negator
-                            __kittycat_toRemove_arr_add(toRemove, k);
-                        }
-                    }
-
-                    for (size_t k = 0; k < toRemove->len; k++)
-                    {
-                        __kittycat_ordered_permission_map_del(opm, opm->order[toRemove->arr[k]]);
-                    }
-                    __kittycat_toRemove_arr_free(toRemove);
+                    __kittycat_ordered_permission_map_clear_negators(opm, perm->namespace_atom);
                 }
                 // If its not a negator, first check if there's a negator
-                struct KittycatPermission *negated = kittycat_new_permission(perm->namespace, perm->perm, true);
+                struct KittycatPermission negatedProbe = __kittycat_permission_probe(perm->namespace_atom, perm->perm_atom, true);
+                struct KittycatPermission *negated = &negatedProbe;
                 struct KittycatPermission *pwc = __kittycat_ordered_permission_map_get(opm, negated);
                 if (pwc != NULL)
                 {
@@ -737,14 +1310,11 @@ struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct S
                     if (pwc != NULL)
                     {
                         // Case 3: The KittycatPermission is already applied, so we can ignore it
-                        kittycat_permission_free(negated);
                         continue;
                     }
                     // Then we can freely add the KittycatPermission
                     __kittycat_ordered_permission_map_set(opm, perm);
                 }
-
-                kittycat_permission_free(negated);
             }
         }
     }
@@ -752,32 +1322,465 @@ struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct S
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
     __kittycat_ordered_permission_map_printf_dbg(opm);
 #endif
+}
+
+struct KittycatPermissionList *__kittycat_staff_permissions_resolve_forward_with(struct __KittycatOrderedPermissionMap *opm, const struct KittycatPartialStaffPositionList *const userPositions, struct kittycat_arena *arena)
+{
+    __kittycat_staff_permissions_apply_forward(opm, userPositions);
 
-    struct KittycatPermissionList *appliedPerms = kittycat_permission_list_new();
+    struct KittycatPermissionList *appliedPerms = kittycat_permission_list_new_in_arena(arena);
+    appliedPerms->perms = __kittycat_perms_realloc(arena, appliedPerms->perms, (opm->len > 0 ? opm->len : 1) * sizeof(struct KittycatPermission *));
 
-    for (size_t i = 0; i < opm->len; i++)
+    for (size_t i = 0; i < opm->order_len; i++)
     {
-        struct KittycatPermission *perm = opm->order[i];
+        struct KittycatPermission *perm = opm->slots[i].perm;
+        if (perm == NULL)
+        {
+            continue; // Tombstone
+        }
 #if defined(DEBUG_FULL) || defined(DEBUG_PRINTF_MINI)
         struct kittycat_string *perm_str = kittycat_permission_to_str(perm);
         printf("order iter: %s\n", perm_str->str);
         kittycat_string_free(perm_str);
 #endif
         // Copy the KittycatPermission
-        struct KittycatPermission *new_perm = kittycat_new_permission(perm->namespace, perm->perm, perm->negator);
-        kittycat_permission_list_add(appliedPerms, new_perm);
+        appliedPerms->perms[appliedPerms->len++] = __kittycat_new_permission_from_atoms_in_arena(arena, perm->namespace_atom, perm->perm_atom, perm->negator);
+    }
+
+    // Leave the map empty (keeping its capacity) for the next resolve
+    __kittycat_ordered_permission_map_clear(opm);
+
+    return appliedPerms;
+}
+
+struct KittycatPermissionSet *__kittycat_staff_permissions_resolve_set_with(struct __KittycatOrderedPermissionMap *opm, const struct KittycatPartialStaffPositionList *const userPositions)
+{
+    __kittycat_staff_permissions_apply_forward(opm, userPositions);
+
+    // The set only needs the packed form of each KittycatPermission, so nothing is copied out of the map
+    struct KittycatPermissionSet *set = __kittycat_permission_set_new(opm->len);
+    for (size_t i = 0; i < opm->order_len; i++)
+    {
+        struct KittycatPermission *perm = opm->slots[i].perm;
+        if (perm != NULL)
+        {
+            __kittycat_permission_set_insert(set, KITTYCAT_PACKED_PERMISSION(perm->namespace_atom, perm->perm_atom, perm->negator));
+        }
     }
 
-    kittycat_string_free(permOverrides->id);
-    __kittycat_free(permOverrides);
-    __kittycat_free(userPositions->positions);
-    __kittycat_free(userPositions);
+    __kittycat_ordered_permission_map_clear(opm);
+
+    return set;
+}
+
+struct KittycatPermissionSet *kittycat_staff_permissions_resolve_to_set(const struct StaffKittycatPermissions *const sp)
+{
+    struct KittycatPartialStaffPosition permOverridesPos = __kittycat_perm_overrides_position(sp);
+    struct KittycatPartialStaffPositionList userPositions;
+    __kittycat_staff_permissions_order_positions(sp, NULL, KITTYCAT_RESOLVE_FLAGS_NONE, &permOverridesPos, &userPositions);
 
+    struct __KittycatOrderedPermissionMap *opm = __kittycat_ordered_permission_map_new();
+    struct KittycatPermissionSet *set = __kittycat_staff_permissions_resolve_set_with(opm, &userPositions);
     __kittycat_ordered_permission_map_free(opm);
+    __kittycat_free(userPositions.positions);
+
+    return set;
+}
+
+// State of a single permission (both its negated and non-negated form) in the reverse resolve engine
+struct __KittycatReverseKeyState
+{
+    // The non-negated packed permission
+    uint64_t key;
+    // When the permission was appended in the forward engine (see __KITTYCAT_RESOLVED_TS)
+    uint64_t ts;
+    // The number of `ns.*` entries of the namespace seen when a negator was decided
+    uint32_t star_epoch;
+    // Whether the permission ends up in the resolved permissions and if so, whether as a negator
+    bool present;
+    bool negator;
+    // Whether lower precedence entries can still move `ts`
+    bool open;
+};
+
+// State of a namespace in the reverse resolve engine
+struct __KittycatReverseNamespaceState
+{
+    uint32_t namespace_atom;
+    // The number of non-negated `ns.*` entries seen so far. Lower precedence negators of the namespace are dropped by these
+    uint32_t stars;
+    // Set once a `ns.@clear` has been seen. Lower precedence entries of the namespace are then skipped
+    bool cleared;
+};
+
+uint64_t __kittycat_reverse_key_state_hash(const void *item, uint64_t seed0, uint64_t seed1)
+{
+    const struct __KittycatReverseKeyState *ks = item;
+    return kittycat_hashmap_xxhash3(&ks->key, sizeof(uint64_t), seed0, seed1);
+}
+
+int __kittycat_reverse_key_state_compare(const void *a, const void *b, void *udata)
+{
+    const struct __KittycatReverseKeyState *ka = a;
+    const struct __KittycatReverseKeyState *kb = b;
+    return ka->key == kb->key ? 0 : 1;
+}
+
+uint64_t __kittycat_reverse_namespace_state_hash(const void *item, uint64_t seed0, uint64_t seed1)
+{
+    const struct __KittycatReverseNamespaceState *ns = item;
+    return kittycat_hashmap_xxhash3(&ns->namespace_atom, sizeof(uint32_t), seed0, seed1);
+}
+
+int __kittycat_reverse_namespace_state_compare(const void *a, const void *b, void *udata)
+{
+    const struct __KittycatReverseNamespaceState *na = a;
+    const struct __KittycatReverseNamespaceState *nb = b;
+    return na->namespace_atom == nb->namespace_atom ? 0 : 1;
+}
+
+int __kittycat_resolved_entry_ts_compare(const void *a, const void *b)
+{
+    const struct __KittycatResolvedEntry *ea = a;
+    const struct __KittycatResolvedEntry *eb = b;
+    return ea->ts < eb->ts ? -1 : (ea->ts > eb->ts ? 1 : 0);
+}
+
+int __kittycat_atom_compare(const void *a, const void *b)
+{
+    uint32_t aa = *(const uint32_t *)a;
+    uint32_t ab = *(const uint32_t *)b;
+    return aa < ab ? -1 : (aa > ab ? 1 : 0);
+}
+
+int __kittycat_packed_permission_compare(const void *a, const void *b)
+{
+    uint64_t pa = *(const uint64_t *)a;
+    uint64_t pb = *(const uint64_t *)b;
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+// Resolves ordered positions by walking the KittycatPermissions from the highest to the lowest precedence
+//
+// A permission is decided by the first entry seen for it. Its position in the output is that of the entry which appended it in the forward
+// engine, found by following lower precedence entries until the permission was last absent or of the other form. A `@clear` settles its
+// whole namespace, after which lower precedence entries of the namespace are skipped, and `global.@clear` stops the walk altogether.
+//
+// Namespaces resolve independently of each other save for `global.@clear`, so if `namespaces` is not NULL, only entries of the
+// `nNamespaces` namespaces in it (sorted in ascending order) are resolved. The result is ordered by `ts` and must be freed by the caller
+struct __KittycatResolvedEntry *__kittycat_staff_permissions_resolve_entries(const struct KittycatPartialStaffPositionList *const userPositions, const uint32_t *const namespaces, const size_t nNamespaces, size_t *len)
+{
+    struct kittycat_hashmap *keys = kittycat_hashmap_new(sizeof(struct __KittycatReverseKeyState), 0, 0, 0, __kittycat_reverse_key_state_hash, __kittycat_reverse_key_state_compare, NULL, NULL);
+    struct kittycat_hashmap *nsStates = kittycat_hashmap_new(sizeof(struct __KittycatReverseNamespaceState), 0, 0, 0, __kittycat_reverse_namespace_state_hash, __kittycat_reverse_namespace_state_compare, NULL, NULL);
+
+    bool done = false;
+    for (size_t i = userPositions->len; i > 0 && !done; i--)
+    {
+        struct KittycatPartialStaffPosition *pos = userPositions->positions[i - 1];
+        for (size_t j = pos->perms->len; j > 0; j--)
+        {
+            struct KittycatPermission *perm = pos->perms->perms[j - 1];
+            uint8_t kind = pos->__kinds != NULL ? pos->__kinds[j - 1] : __kittycat_permission_classify(perm);
+
+            if (kind & __KITTYCAT_ENTRY_GLOBAL_CLEAR)
+            {
+                // Nothing of lower precedence can survive
+                done = true;
+                break;
+            }
+
+            if (namespaces != NULL && bsearch(&perm->namespace_atom, namespaces, nNamespaces, sizeof(uint32_t), __kittycat_atom_compare) == NULL)
+            {
+                continue;
+            }
+
+            struct __KittycatReverseNamespaceState nsProbe = {perm->namespace_atom, 0, false};
+            struct __KittycatReverseNamespaceState *nss = (struct __KittycatReverseNamespaceState *)kittycat_hashmap_get(nsStates, &nsProbe);
+            if (nss == NULL)
+            {
+                kittycat_hashmap_set(nsStates, &nsProbe);
+                nss = (struct __KittycatReverseNamespaceState *)kittycat_hashmap_get(nsStates, &nsProbe);
+            }
+
+            if (nss->cleared)
+            {
+                continue;
+            }
+
+            if (kind & __KITTYCAT_ENTRY_CLEAR)
+            {
+                nss->cleared = true;
+                continue;
+            }
+
+            uint64_t t = __KITTYCAT_RESOLVED_TS(i - 1, j - 1);
+            struct __KittycatReverseKeyState keyProbe = {KITTYCAT_PACKED_PERMISSION(perm->namespace_atom, perm->perm_atom, false), t, nss->stars, true, perm->negator, true};
+            struct __KittycatReverseKeyState *ks = (struct __KittycatReverseKeyState *)kittycat_hashmap_get(keys, &keyProbe);
+
+            if (ks == NULL)
+            {
+                if (perm->negator && nss->stars > 0)
+                {
+                    // A higher precedence `ns.*` drops this negator
+                    keyProbe.present = false;
+                    keyProbe.open = false;
+                }
+                kittycat_hashmap_set(keys, &keyProbe);
+            }
+            else if (ks->open)
+            {
+                // A negator run is also ended by any `ns.*` seen since it was decided
+                bool sameRun = ks->negator == perm->negator && (!ks->negator || ks->star_epoch == nss->stars);
+                if (sameRun)
+                {
+                    ks->ts = t;
+                }
+                else
+                {
+                    ks->open = false;
+                }
+            }
+
+            if (kind & __KITTYCAT_ENTRY_WILDCARD)
+            {
+                nss->stars++;
+            }
+        }
+    }
+
+    // Order the resolved permissions as the forward engine appended them
+    size_t n = 0;
+    struct __KittycatResolvedEntry *resolved = __kittycat_malloc((kittycat_hashmap_count(keys) + 1) * sizeof(struct __KittycatResolvedEntry));
+    size_t iter = 0;
+    void *item;
+    while (kittycat_hashmap_iter(keys, &iter, &item))
+    {
+        struct __KittycatReverseKeyState *ks = item;
+        if (ks->present)
+        {
+            resolved[n].packed = ks->key | (ks->negator ? KITTYCAT_PACKED_PERMISSION_NEGATOR : 0);
+            resolved[n].ts = ks->ts;
+            n++;
+        }
+    }
+    qsort(resolved, n, sizeof(struct __KittycatResolvedEntry), __kittycat_resolved_entry_ts_compare);
+
+    kittycat_hashmap_free(keys);
+    kittycat_hashmap_free(nsStates);
+
+    *len = n;
+    return resolved;
+}
+
+// Resolves ordered positions with `__kittycat_staff_permissions_resolve_entries`
+//
+// This produces exactly the same output as `__kittycat_staff_permissions_resolve_forward`
+struct KittycatPermissionList *__kittycat_staff_permissions_resolve_reverse(const struct KittycatPartialStaffPositionList *const userPositions, struct kittycat_arena *arena)
+{
+    size_t n = 0;
+    struct __KittycatResolvedEntry *resolved = __kittycat_staff_permissions_resolve_entries(userPositions, NULL, 0, &n);
+
+    struct KittycatPermissionList *appliedPerms = kittycat_permission_list_new_in_arena(arena);
+    appliedPerms->perms = __kittycat_perms_realloc(arena, appliedPerms->perms, (n > 0 ? n : 1) * sizeof(struct KittycatPermission *));
+    for (size_t i = 0; i < n; i++)
+    {
+        appliedPerms->perms[appliedPerms->len++] = __kittycat_new_permission_from_atoms_in_arena(
+            arena,
+            KITTYCAT_PACKED_PERMISSION_NAMESPACE(resolved[i].packed),
+            KITTYCAT_PACKED_PERMISSION_PERM(resolved[i].packed),
+            KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(resolved[i].packed));
+    }
+
+    __kittycat_free(resolved);
+
+    return appliedPerms;
+}
+
+struct KittycatPermissionList *__kittycat_staff_permissions_resolve(const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena, struct kittycat_arena *scratch, struct __KittycatOrderedPermissionMap *opm, const uint32_t flags)
+{
+    struct kittycat_arena *scratchArena = scratch != NULL ? scratch : arena;
+
+    struct KittycatPartialStaffPosition permOverridesPos = __kittycat_perm_overrides_position(sp);
+    struct KittycatPartialStaffPositionList userPositions;
+    __kittycat_staff_permissions_order_positions(sp, scratchArena, flags, &permOverridesPos, &userPositions);
+
+    struct KittycatPermissionList *appliedPerms;
+    if (flags & KITTYCAT_RESOLVE_FLAGS_REVERSE)
+    {
+        appliedPerms = __kittycat_staff_permissions_resolve_reverse(&userPositions, arena);
+    }
+    else if (opm != NULL)
+    {
+        appliedPerms = __kittycat_staff_permissions_resolve_forward_with(opm, &userPositions, arena);
+    }
+    else
+    {
+        appliedPerms = __kittycat_staff_permissions_resolve_forward(&userPositions, arena);
+    }
+
+    if (scratchArena == NULL)
+    {
+        __kittycat_free(userPositions.positions);
+    }
 
     return appliedPerms;
 }
 
+// The state of a permission relevant to `kittycat_staff_has_perm`
+struct __KittycatStaffPermState
+{
+    uint32_t namespace_atom;
+    uint32_t perm_atom;
+    // Whether the permission is in the resolved permissions and if so, whether as a negator
+    bool present;
+    bool negator;
+};
+
+// Applies one KittycatPermission of a position to the states of the relevant permissions, just like the forward engine would
+void __kittycat_staff_perm_states_apply(struct __KittycatStaffPermState *states, const size_t len, const struct KittycatPermission *const perm)
+{
+    if (perm->perm_atom == KITTYCAT_ATOM_CLEAR)
+    {
+        for (size_t k = 0; k < len; k++)
+        {
+            if (perm->namespace_atom == KITTYCAT_ATOM_GLOBAL || states[k].namespace_atom == perm->namespace_atom)
+            {
+                states[k].present = false;
+            }
+        }
+        return;
+    }
+
+    bool wildcard = !perm->negator && perm->perm_atom == KITTYCAT_ATOM_WILDCARD;
+    for (size_t k = 0; k < len; k++)
+    {
+        if (states[k].namespace_atom != perm->namespace_atom)
+        {
+            continue;
+        }
+
+        if (states[k].perm_atom == perm->perm_atom)
+        {
+            // The latest form of a permission replaces the other one
+            states[k].present = true;
+            states[k].negator = perm->negator;
+        }
+        else if (wildcard && states[k].present && states[k].negator)
+        {
+            // A non-negated `ns.*` drops every negator of the namespace
+            states[k].present = false;
+        }
+    }
+}
+
+// Applies every KittycatPermission of a position to the states of the relevant permissions
+void __kittycat_staff_perm_states_apply_position(struct __KittycatStaffPermState *states, const size_t len, const struct KittycatPermissionList *const perms)
+{
+    for (size_t j = 0; j < perms->len; j++)
+    {
+        __kittycat_staff_perm_states_apply(states, len, perms->perms[j]);
+    }
+}
+
+// Whether the position at `a` is applied before the one at `b`. Positions are applied by index in descending order and then in the order
+// they were added in. The perm overrides (at `n`) count as index 0, applied after every other position of index 0
+bool __kittycat_staff_position_before(const struct StaffKittycatPermissions *const sp, const size_t a, const size_t b)
+{
+    size_t n = sp->user_positions->len;
+    int32_t ia = a < n ? sp->user_positions->positions[a]->index : 0;
+    int32_t ib = b < n ? sp->user_positions->positions[b]->index : 0;
+    return ia != ib ? ia > ib : a < b;
+}
+
+bool kittycat_staff_has_perm(const struct StaffKittycatPermissions *const sp, const struct KittycatPermission *const perm)
+{
+    // `kittycat_has_perm` only looks at these permissions in the resolved permissions. They are tracked through the positions instead of
+    // resolving everything. Duplicates (e.g. when checking a global permission) are harmless
+    struct __KittycatStaffPermState states[4] = {
+        {KITTYCAT_ATOM_GLOBAL, KITTYCAT_ATOM_WILDCARD, false, false},
+        {KITTYCAT_ATOM_GLOBAL, perm->perm_atom, false, false},
+        {perm->namespace_atom, KITTYCAT_ATOM_WILDCARD, false, false},
+        {perm->namespace_atom, perm->perm_atom, false, false},
+    };
+
+    // Apply the positions (with the perm overrides as position `n`) in order. This is a simple walk if the positions are already sorted,
+    // which is the common case, and otherwise repeatedly picks the next position to apply so that nothing has to be allocated
+    size_t n = sp->user_positions->len;
+    bool sorted = true;
+    for (size_t i = 1; i < n && sorted; i++)
+    {
+        sorted = sp->user_positions->positions[i - 1]->index >= sp->user_positions->positions[i]->index;
+    }
+
+    if (sorted)
+    {
+        bool overridesApplied = false;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!overridesApplied && sp->user_positions->positions[i]->index < 0)
+            {
+                __kittycat_staff_perm_states_apply_position(states, 4, sp->perm_overrides);
+                overridesApplied = true;
+            }
+            __kittycat_staff_perm_states_apply_position(states, 4, sp->user_positions->positions[i]->perms);
+        }
+        if (!overridesApplied)
+        {
+            __kittycat_staff_perm_states_apply_position(states, 4, sp->perm_overrides);
+        }
+    }
+    else
+    {
+        size_t last = __KITTYCAT_SLOT_NONE;
+        for (size_t step = 0; step <= n; step++)
+        {
+            size_t next = __KITTYCAT_SLOT_NONE;
+            for (size_t i = 0; i <= n; i++)
+            {
+                if ((last == __KITTYCAT_SLOT_NONE || __kittycat_staff_position_before(sp, last, i)) &&
+                    (next == __KITTYCAT_SLOT_NONE || __kittycat_staff_position_before(sp, i, next)))
+                {
+                    next = i;
+                }
+            }
+
+            __kittycat_staff_perm_states_apply_position(states, 4, next < n ? sp->user_positions->positions[next]->perms : sp->perm_overrides);
+            last = next;
+        }
+    }
+
+    // Same as `kittycat_has_perm` over the tracked permissions
+    if (states[0].present && !states[0].negator)
+    {
+        return true;
+    }
+
+    bool hasPerm = false;
+    bool hasNegator = false;
+    for (size_t k = 0; k < 4; k++)
+    {
+        hasPerm = hasPerm || states[k].present;
+        hasNegator = hasNegator || (states[k].present && states[k].negator);
+    }
+
+    return hasPerm && !hasNegator;
+}
+
+struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct StaffKittycatPermissions *const sp)
+{
+    return __kittycat_staff_permissions_resolve(sp, NULL, NULL, NULL, KITTYCAT_RESOLVE_FLAGS_NONE);
+}
+
+struct KittycatPermissionList *kittycat_staff_permissions_resolve_with_flags(const struct StaffKittycatPermissions *const sp, const uint32_t flags)
+{
+    return __kittycat_staff_permissions_resolve(sp, NULL, NULL, NULL, flags);
+}
+
+struct KittycatPermissionList *kittycat_staff_permissions_resolve_in_arena(const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena)
+{
+    return __kittycat_staff_permissions_resolve(sp, arena, NULL, NULL, KITTYCAT_RESOLVE_FLAGS_NONE);
+}
+
 void kittycat_permission_check_patch_changes_result_free(struct KittycatPermissionCheckPatchChangesResult *result)
 {
     if (result->failing_perms != NULL)
@@ -835,136 +1838,5 @@ struct KittycatPermissionCheckPatchChangesResult kittycat_check_patch_changes(
     struct KittycatPermissionList *current_perms,
     struct KittycatPermissionList *new_perms)
 {
-    struct kittycat_hashmap *hset_1 = kittycat_hashmap_new(
-        sizeof(struct KittycatPermission),
-        0,
-        0,
-        0,
-        __kittycat_permission_hash,
-        __kittycat_permission_compare,
-        NULL,
-        NULL);
-
-    for (size_t i = 0; i < manager_perms->len; i++)
-    {
-        struct KittycatPermission *perm = manager_perms->perms[i];
-        kittycat_hashmap_set(hset_1, perm);
-    }
-
-    struct kittycat_hashmap *hset_2 = kittycat_hashmap_new(
-        sizeof(struct KittycatPermission),
-        0,
-        0,
-        0,
-        __kittycat_permission_hash,
-        __kittycat_permission_compare,
-        NULL,
-        NULL);
-
-    for (size_t i = 0; i < current_perms->len; i++)
-    {
-        struct KittycatPermission *perm = current_perms->perms[i];
-        kittycat_hashmap_set(hset_2, perm);
-    }
-
-    struct KittycatPermissionList *changed = kittycat_permission_list_new();
-
-    size_t iter = 0;
-    void *item;
-    while (kittycat_hashmap_iter(hset_1, &iter, &item))
-    {
-        // If unique to hset_1, then add to changed
-        struct KittycatPermission *p = item;
-        if (kittycat_hashmap_get(hset_2, p) == NULL)
-        {
-            kittycat_permission_list_add(changed, kittycat_new_permission(p->namespace, p->perm, p->negator));
-        }
-    }
-
-    iter = 0;
-    while (kittycat_hashmap_iter(hset_2, &iter, &item))
-    {
-        // If unique to hset_2, then add to changed
-        struct KittycatPermission *p = item;
-        if (kittycat_hashmap_get(hset_1, p) == NULL)
-        {
-            kittycat_permission_list_add(changed, p);
-        }
-    }
-
-    kittycat_hashmap_free(hset_1);
-    kittycat_hashmap_free(hset_2);
-
-    for (size_t i = 0; i < changed->len; i++)
-    {
-        struct KittycatPermission *perm = changed->perms[i];
-
-        // Strip the negator to check it
-        struct KittycatPermission *resolved_perm = kittycat_new_permission(perm->namespace, perm->perm, false);
-
-        // Check if the user has the KittycatPermission
-        if (!kittycat_has_perm(manager_perms, resolved_perm))
-        {
-            kittycat_permission_free(resolved_perm);
-            kittycat_permission_list_free(changed);
-
-            return (struct KittycatPermissionCheckPatchChangesResult){
-                .state = KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_NO_PERMISSION,
-                .failing_perms = kittycat_permission_list_new_with_perms(
-                    (struct KittycatPermission *[]){
-                        perm},
-                    1),
-            };
-        }
-
-        if (kittycat_string_equal(perm->perm, &__kittycat_perm_global_perm))
-        {
-            // Ensure that new_perms has *at least* negators that manager_perms has within the namespace
-            for (size_t j = 0; j < manager_perms->len; j++)
-            {
-                struct KittycatPermission *perms = manager_perms->perms[j];
-                if (perms->negator)
-                {
-                    continue;
-                }
-
-                if (kittycat_string_equal(perms->namespace, perm->namespace))
-                {
-                    // Then we have a negator in the same namespace
-                    bool in_new_perms = false;
-                    for (size_t k = 0; k < new_perms->len; k++)
-                    {
-                        struct KittycatPermission *new_perm = new_perms->perms[k];
-                        if (kittycat_string_equal(new_perm->namespace, perm->namespace) && kittycat_string_equal(new_perm->perm, perm->perm) && new_perm->negator == perm->negator)
-                        {
-                            in_new_perms = true;
-                            break;
-                        }
-                    }
-
-                    if (!in_new_perms)
-                    {
-                        kittycat_permission_free(resolved_perm);
-                        kittycat_permission_list_free(changed);
-
-                        return (struct KittycatPermissionCheckPatchChangesResult){
-                            .state = KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD,
-                            .failing_perms = kittycat_permission_list_new_with_perms(
-                                (struct KittycatPermission *[]){
-                                    perm,
-                                    perms},
-                                2),
-                        };
-                    }
-                }
-            }
-        }
-
-        kittycat_permission_free(resolved_perm); // Free the resolved KittycatPermission
-    }
-
-    kittycat_permission_list_free(changed); // Free the changed KittycatPermissions
-
-    return (struct KittycatPermissionCheckPatchChangesResult){
-        .state = KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK};
+    return __kittycat_patch_check(NULL, manager_perms, current_perms, new_perms);
 }
\ No newline at end of file
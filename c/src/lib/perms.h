@@ -21,6 +21,15 @@ extern "C"
         void *(*realloc)(void *, size_t),
         void (*free)(void *));
 
+    // Describes who owns the namespace and perm strings of a KittycatPermission
+    enum KittycatPermissionOwnership
+    {
+        // namespace and perm belong to the caller, who must keep them alive for as long as the KittycatPermission (`kittycat_new_permission`)
+        KITTYCAT_PERMISSION_OWNERSHIP_CALLER,
+        // namespace and perm are the shared interned strings and must not be freed (`kittycat_permission_new_from_str` etc.)
+        KITTYCAT_PERMISSION_OWNERSHIP_INTERNED,
+    };
+
     // Represents a permission
     struct KittycatPermission
     {
@@ -28,8 +37,19 @@ extern "C"
         struct kittycat_string *perm;
         bool negator;
 
+        // The interned atoms of namespace and perm (see `kittycat_string_intern`)
+        //
+        // These are set on construction and are what kittycat uses to compare and hash permissions (see
+        // `kittycat_permission_pack`), so namespace and perm must not be changed after a KittycatPermission has been created
+        uint32_t namespace_atom;
+        uint32_t perm_atom;
+
+        // Who owns namespace and perm
+        enum KittycatPermissionOwnership ownership;
+
         // Internal
-        bool __isCloned;
+        // The arena the KittycatPermission was allocated in, if any
+        struct kittycat_arena *__arena;
     };
 
     // Creates a new KittycatPermission from a string.
@@ -37,14 +57,45 @@ extern "C"
     // Caller must free the KittycatPermission after use using `kittycat_permission_free`
     struct KittycatPermission *kittycat_new_permission(struct kittycat_string *namespace, struct kittycat_string *perm, bool negator);
 
-    // Same as `kittycat_new_permission` but clones the underlying namespace and perm strings.
-    // Note that the original namespace+perm will be cloned and automatically freed when the KittycatPermission is freed using `kittycat_permission_free`
+    // Same as `kittycat_new_permission` but allocates the KittycatPermission in `arena`
+    //
+    // The KittycatPermission is released when the arena is reset or freed, calling `kittycat_permission_free` on it is a no-op
+    struct KittycatPermission *kittycat_new_permission_in_arena(struct kittycat_arena *arena, struct kittycat_string *namespace, struct kittycat_string *perm, bool negator);
+
+    // Same as `kittycat_new_permission` but does not keep a reference to the passed namespace and perm strings.
+    // The KittycatPermission instead points to the shared interned copies of namespace+perm which must not be freed by the caller
     struct KittycatPermission *kittycat_new_permission_cloned(struct kittycat_string *namespace, struct kittycat_string *perm, bool negator);
 
     // Creates a new KittycatPermission from the canonical representation of the permission `str`
+    //
+    // The namespace and perm of the returned KittycatPermission are the shared interned strings, no substrings are copied
     // Note: Caller must free the KittycatPermission after use using `kittycat_permission_free`
     struct KittycatPermission *kittycat_permission_new_from_str(struct kittycat_string *str);
 
+    // Same as `kittycat_permission_new_from_str` but allocates the KittycatPermission in `arena`
+    struct KittycatPermission *kittycat_permission_new_from_str_in_arena(struct kittycat_arena *arena, struct kittycat_string *str);
+
+    // A permission parsed in place: namespace and perm point into the parsed buffer and are not NUL terminated
+    struct KittycatPermissionView
+    {
+        struct kittycat_string_view namespace;
+        struct kittycat_string_view perm;
+        bool negator;
+    };
+
+    // Parses the canonical representation of a permission (`len` bytes at `str`) into a KittycatPermissionView
+    //
+    // This never allocates or interns anything. Returns false (leaving `out` untouched) if `len` is 0
+    bool kittycat_permission_view_parse(const char *const str, const size_t len, struct KittycatPermissionView *out);
+
+    // Creates a new KittycatPermission from a KittycatPermissionView
+    //
+    // namespace and perm are the interned strings (`KITTYCAT_PERMISSION_OWNERSHIP_INTERNED`), so the buffer `view` points into does not
+    // need to outlive the KittycatPermission. String data is only copied the first time the interner sees it: once every namespace and
+    // perm is known, the KittycatPermission itself is the only allocation.
+    // Note: Caller must free the KittycatPermission after use using `kittycat_permission_free`
+    struct KittycatPermission *kittycat_permission_new_from_view(const struct KittycatPermissionView *const view);
+
     // Converts a permission to its canonical string representation
     struct kittycat_string *kittycat_permission_to_str(struct KittycatPermission *p);
 
@@ -56,11 +107,21 @@ extern "C"
     {
         struct KittycatPermission **perms;
         size_t len;
+
+        // Internal
+        // The arena the KittycatPermissionList was allocated in, if any
+        struct kittycat_arena *__arena;
     };
 
     // Creates a new KittycatPermissionList
     struct KittycatPermissionList *kittycat_permission_list_new();
 
+    // Same as `kittycat_permission_list_new` but allocates the list (and grows it) in `arena`
+    //
+    // The list is released when the arena is reset or freed. `kittycat_permission_list_free` does not free the list itself but still
+    // frees any heap allocated KittycatPermission that was added to it, so a list in an arena should normally only hold permissions from the same arena
+    struct KittycatPermissionList *kittycat_permission_list_new_in_arena(struct kittycat_arena *arena);
+
     // Adds a permission to the list
     void kittycat_permission_list_add(struct KittycatPermissionList *pl, struct KittycatPermission *const perm);
 
@@ -71,6 +132,11 @@ extern "C"
     struct KittycatPermissionList *kittycat_permission_list_new_with_perms(
         struct KittycatPermission **perms, size_t len);
 
+    // Creates a new KittycatPermissionList from `len` bytes at `buf` holding canonical permissions separated by `sep` (e.g. a database row)
+    //
+    // Empty entries are skipped. Every KittycatPermission is made with `kittycat_permission_new_from_view`, so `buf` is not referenced after this call
+    struct KittycatPermissionList *kittycat_permission_list_new_from_buffer(const char *const buf, const size_t len, const char sep);
+
     // Joins a KittycatPermission list to produce a string
     //
     // The canonical string representation is used for each individual input KittycatPermission
@@ -88,6 +154,78 @@ extern "C"
     // This is the key primitive within kittycat
     bool kittycat_has_perm(const struct KittycatPermissionList *const perms, const struct KittycatPermission *const perm);
 
+    // Same as `kittycat_has_perm` but takes the canonical representation of the permission to check (`len` bytes at `perm`, no NUL terminator needed)
+    //
+    // The permission is parsed in place and never allocates, making this the cheapest way to check a permission coming from a database row
+    bool kittycat_has_perm_cstr(const struct KittycatPermissionList *const perms, const char *const perm, const size_t len);
+
+    // Same as `kittycat_has_perm_cstr` but the user permissions are also `n` raw canonical permission strings
+    //
+    // `user_perm_lens[i]` is the length of `user_perms[i]`. If `user_perm_lens` is NULL, every user permission must be NUL terminated.
+    // Like `kittycat_has_perm_cstr`, this never allocates
+    bool kittycat_has_perm_cstr_arr(const char *const *user_perms, const size_t *user_perm_lens, const size_t n, const char *const perm, const size_t len);
+
+    // Packed KittycatPermissions
+    //
+    // A packed KittycatPermission is a KittycatPermission stored as a single 64-bit value: bit 63 is the negator,
+    // bits 32-62 hold the namespace atom and bits 0-31 hold the perm atom. Packed permissions can be compared with `==`
+    // and copied freely as they do not own any memory
+#define KITTYCAT_PACKED_PERMISSION_NEGATOR ((uint64_t)1 << 63)
+
+// Creates a packed permission from its namespace atom, perm atom and negator
+#define KITTYCAT_PACKED_PERMISSION(namespace_atom, perm_atom, negator) \
+    ((((uint64_t)(namespace_atom) & 0x7FFFFFFF) << 32) | (uint64_t)(uint32_t)(perm_atom) | ((negator) ? KITTYCAT_PACKED_PERMISSION_NEGATOR : 0))
+
+// Returns the namespace atom of a packed permission
+#define KITTYCAT_PACKED_PERMISSION_NAMESPACE(packed) ((uint32_t)(((packed) >> 32) & 0x7FFFFFFF))
+
+// Returns the perm atom of a packed permission
+#define KITTYCAT_PACKED_PERMISSION_PERM(packed) ((uint32_t)((packed) & 0xFFFFFFFF))
+
+// Returns whether a packed permission is a negator
+#define KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(packed) (((packed) & KITTYCAT_PACKED_PERMISSION_NEGATOR) != 0)
+
+    // Packs a KittycatPermission into a single 64-bit value
+    uint64_t kittycat_permission_pack(const struct KittycatPermission *const p);
+
+    // Creates a new KittycatPermission from a packed permission. The namespace and perm point to the shared interned strings
+    // Note: Caller must free the KittycatPermission after use using `kittycat_permission_free`
+    struct KittycatPermission *kittycat_permission_unpack(const uint64_t packed);
+
+    // Packs the canonical representation of a permission (`len` bytes at `str`, no NUL terminator needed) directly
+    // without creating a KittycatPermission. The namespace and perm are interned
+    uint64_t kittycat_permission_pack_str(const char *const str, const size_t len);
+
+    // Represents a flat list of packed permissions stored contiguously
+    struct KittycatPackedPermissionList
+    {
+        uint64_t *perms;
+        size_t len;
+
+        // Internal
+        size_t __cap;
+    };
+
+    // Creates a new KittycatPackedPermissionList
+    struct KittycatPackedPermissionList *kittycat_packed_permission_list_new();
+
+    // Adds a packed permission to the list
+    void kittycat_packed_permission_list_add(struct KittycatPackedPermissionList *ppl, const uint64_t perm);
+
+    // Creates a new KittycatPackedPermissionList holding the packed form of every KittycatPermission in `pl`
+    struct KittycatPackedPermissionList *kittycat_permission_list_pack(const struct KittycatPermissionList *const pl);
+
+    // Creates a new KittycatPermissionList from a KittycatPackedPermissionList
+    //
+    // The returned list must be freed by the caller using `kittycat_permission_list_free`
+    struct KittycatPermissionList *kittycat_packed_permission_list_unpack(const struct KittycatPackedPermissionList *const ppl);
+
+    // Frees the KittycatPackedPermissionList
+    void kittycat_packed_permission_list_free(struct KittycatPackedPermissionList *ppl);
+
+    // Same as `kittycat_has_perm` but for packed permission lists
+    bool kittycat_packed_has_perm(const struct KittycatPackedPermissionList *const perms, const uint64_t perm);
+
     // A PartialStaffPosition is a partial representation of a staff position
     // for the purposes of permission resolution
     struct KittycatPartialStaffPosition
@@ -98,6 +236,12 @@ extern "C"
         int32_t index;
         // The preset KittycatPermissions of this position
         struct KittycatPermissionList *perms;
+
+        // Internal
+        // Set for positions owned by a kittycat_position_registry. These are shared between StaffKittycatPermissions and never freed by them
+        bool __shared;
+        // How the resolve engines must treat each KittycatPermission of `perms`, classified in advance. NULL if they are classified while resolving
+        uint8_t *__kinds;
     };
 
     // Creates a new KittycatPartialStaffPosition given its id, index (lower means higher in hierarchy) and the permission list of the position
@@ -144,8 +288,39 @@ extern "C"
     void kittycat_staff_permissions_free(struct StaffKittycatPermissions *sp);
 
     // Resolves the KittycatPermissions of a staff member
+    //
+    // Positions are applied in descending order of their index. Positions sharing an index are applied in the order they appear in
+    // `user_positions` and `perm_overrides` is applied last among the positions with index 0 (the same as the Rust port's stable sort)
     struct KittycatPermissionList *kittycat_staff_permissions_resolve(const struct StaffKittycatPermissions *const sp);
 
+    // Flags changing how `kittycat_staff_permissions_resolve_with_flags` resolves KittycatPermissions
+    enum KittycatResolveFlags
+    {
+        KITTYCAT_RESOLVE_FLAGS_NONE = 0,
+        // The caller guarantees that `user_positions` is already sorted by index in descending order, so it is not sorted again
+        KITTYCAT_RESOLVE_FLAGS_PRESORTED = 1 << 0,
+        // Use the reverse resolve engine, which walks positions from the highest precedence (perm overrides) down and skips entries of
+        // namespaces that are already settled by a `@clear`. Produces exactly the same result as the default engine
+        KITTYCAT_RESOLVE_FLAGS_REVERSE = 1 << 1,
+    };
+
+    // Same as `kittycat_staff_permissions_resolve` but takes a bitwise OR of `KittycatResolveFlags`
+    struct KittycatPermissionList *kittycat_staff_permissions_resolve_with_flags(const struct StaffKittycatPermissions *const sp, const uint32_t flags);
+
+    // Same as `kittycat_staff_permissions_resolve` but allocates the returned list, its KittycatPermissions and the sorted positions
+    // in `arena`, so the result is released by `kittycat_arena_reset`
+    //
+    // The map the resolve engine works in is still allocated with the allocator hooks and freed before returning. Use a
+    // `kittycat_resolver` to keep it between resolves
+    struct KittycatPermissionList *kittycat_staff_permissions_resolve_in_arena(const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena);
+
+    // Returns whether a staff member has the permission `perm`, exactly like calling `kittycat_has_perm` on the result of
+    // `kittycat_staff_permissions_resolve`, but without resolving (or allocating) anything
+    //
+    // Only the few permissions `kittycat_has_perm` looks at (`global.*`, `global.<perm>`, `<ns>.*` and `<ns>.<perm>`) are followed through
+    // the positions, along with the `@clear`s affecting them. Use this when a single answer is needed, and resolve once when checking many
+    bool kittycat_staff_has_perm(const struct StaffKittycatPermissions *const sp, const struct KittycatPermission *const perm);
+
     // Stores the result of `kittycat_permission_check_patch_changes`
     enum KittycatPermissionCheckPatchChangesResultState
     {
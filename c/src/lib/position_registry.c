@@ -0,0 +1,174 @@
+#include "position_registry.h"
+#include "hashmap.h"
+#include "internal.h"
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_position_registry_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+// An entry in the id -> handle kittycat_hashmap of a kittycat_position_registry. `id` points to the id of the position
+struct __KittycatPositionIdEntry
+{
+    const char *id;
+    size_t len;
+    size_t handle;
+};
+
+uint64_t __kittycat_position_id_entry_hash(const void *item, uint64_t seed0, uint64_t seed1)
+{
+    const struct __KittycatPositionIdEntry *e = item;
+    return kittycat_hashmap_xxhash3(e->id, e->len, seed0, seed1);
+}
+
+int __kittycat_position_id_entry_compare(const void *a, const void *b, void *udata)
+{
+    const struct __KittycatPositionIdEntry *ea = a;
+    const struct __KittycatPositionIdEntry *eb = b;
+    return ea->len == eb->len && memcmp(ea->id, eb->id, ea->len) == 0 ? 0 : 1;
+}
+
+void __kittycat_position_registry_parse(struct KittycatPartialStaffPosition *pos, const char *const *perms, const size_t *perm_lens, const size_t len)
+{
+    pos->perms = kittycat_permission_list_new();
+    pos->__kinds = __kittycat_malloc((len > 0 ? len : 1) * sizeof(uint8_t));
+
+    for (size_t i = 0; i < len; i++)
+    {
+        size_t perm_len = perm_lens != NULL ? perm_lens[i] : strlen(perms[i]);
+        if (perm_len == 0)
+        {
+            continue;
+        }
+
+        struct KittycatPermission *perm = kittycat_permission_unpack(kittycat_permission_pack_str(perms[i], perm_len));
+        pos->__kinds[pos->perms->len] = __kittycat_permission_classify(perm);
+        kittycat_permission_list_add(pos->perms, perm);
+    }
+}
+
+struct kittycat_position_registry *kittycat_position_registry_new()
+{
+    struct kittycat_position_registry *registry = __kittycat_malloc(sizeof(struct kittycat_position_registry));
+    registry->len = 0;
+    registry->__cap = 8;
+    registry->__positions = __kittycat_malloc(registry->__cap * sizeof(struct KittycatPartialStaffPosition *));
+    registry->__ids = kittycat_hashmap_new(sizeof(struct __KittycatPositionIdEntry), 0, 0, 0, __kittycat_position_id_entry_hash, __kittycat_position_id_entry_compare, NULL, NULL);
+    return registry;
+}
+
+size_t kittycat_position_registry_add(
+    struct kittycat_position_registry *registry,
+    const char *const id,
+    const size_t id_len,
+    const int32_t index,
+    const char *const *perms,
+    const size_t *perm_lens,
+    const size_t len)
+{
+    if (kittycat_position_registry_find(registry, id, id_len) != KITTYCAT_POSITION_HANDLE_INVALID)
+    {
+        return KITTYCAT_POSITION_HANDLE_INVALID;
+    }
+
+    struct KittycatPartialStaffPosition *pos = __kittycat_malloc(sizeof(struct KittycatPartialStaffPosition));
+    pos->id = kittycat_string_clone_from_chararr(id, id_len);
+    pos->index = index;
+    pos->__shared = true;
+    __kittycat_position_registry_parse(pos, perms, perm_lens, len);
+
+    if (registry->len == registry->__cap)
+    {
+        registry->__cap *= 2;
+        registry->__positions = __kittycat_realloc(registry->__positions, registry->__cap * sizeof(struct KittycatPartialStaffPosition *));
+    }
+
+    size_t handle = registry->len;
+    registry->__positions[handle] = pos;
+    registry->len++;
+
+    struct __KittycatPositionIdEntry entry = {pos->id->str, pos->id->len, handle};
+    kittycat_hashmap_set(registry->__ids, &entry);
+
+    return handle;
+}
+
+bool kittycat_position_registry_update(
+    struct kittycat_position_registry *registry,
+    const size_t handle,
+    const int32_t index,
+    const char *const *perms,
+    const size_t *perm_lens,
+    const size_t len)
+{
+    if (handle >= registry->len)
+    {
+        return false;
+    }
+
+    struct KittycatPartialStaffPosition *pos = registry->__positions[handle];
+    kittycat_permission_list_free(pos->perms);
+    __kittycat_free(pos->__kinds);
+
+    pos->index = index;
+    __kittycat_position_registry_parse(pos, perms, perm_lens, len);
+    return true;
+}
+
+size_t kittycat_position_registry_find(const struct kittycat_position_registry *const registry, const char *const id, const size_t id_len)
+{
+    struct __KittycatPositionIdEntry probe = {id, id_len, KITTYCAT_POSITION_HANDLE_INVALID};
+    const struct __KittycatPositionIdEntry *e = kittycat_hashmap_get(registry->__ids, &probe);
+    return e != NULL ? e->handle : KITTYCAT_POSITION_HANDLE_INVALID;
+}
+
+const struct KittycatPartialStaffPosition *kittycat_position_registry_get(const struct kittycat_position_registry *const registry, const size_t handle)
+{
+    if (handle >= registry->len)
+    {
+        return NULL;
+    }
+
+    return registry->__positions[handle];
+}
+
+bool kittycat_staff_permissions_add_position(struct StaffKittycatPermissions *sp, const struct kittycat_position_registry *const registry, const size_t handle)
+{
+    if (handle >= registry->len)
+    {
+        return false;
+    }
+
+    kittycat_partial_staff_position_list_add(sp->user_positions, registry->__positions[handle]);
+    return true;
+}
+
+void kittycat_position_registry_free(struct kittycat_position_registry *registry)
+{
+    if (registry == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < registry->len; i++)
+    {
+        struct KittycatPartialStaffPosition *pos = registry->__positions[i];
+        kittycat_string_free(pos->id);
+        kittycat_permission_list_free(pos->perms);
+        __kittycat_free(pos->__kinds);
+        __kittycat_free(pos);
+    }
+
+    kittycat_hashmap_free(registry->__ids);
+    __kittycat_free(registry->__positions);
+    __kittycat_free(registry);
+}
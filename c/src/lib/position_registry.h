@@ -0,0 +1,88 @@
+#ifndef KITTYCAT_POSITION_REGISTRY_H
+#define KITTYCAT_POSITION_REGISTRY_H
+
+#include "perms.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator for the kittycat position registry
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_position_registry_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // Returned in place of a position handle when there is no such position
+#define KITTYCAT_POSITION_HANDLE_INVALID ((size_t)-1)
+
+    // A registry of staff positions, each parsed once and shared by every StaffKittycatPermissions holding it
+    //
+    // Services usually only have a few dozen distinct positions but resolve the permissions of many staff members holding them. Registering
+    // positions up front means their permissions are parsed and classified for the resolve engines (clears, wildcards, negators) only once.
+    // Positions are referenced by handle, which stays valid for the lifetime of the registry
+    struct kittycat_position_registry
+    {
+        // Number of positions in the registry
+        size_t len;
+
+        // Internal
+        struct KittycatPartialStaffPosition **__positions;
+        size_t __cap;
+        struct kittycat_hashmap *__ids;
+    };
+
+    // Creates a new, empty kittycat_position_registry
+    struct kittycat_position_registry *kittycat_position_registry_new();
+
+    // Parses and registers the position `id` (`id_len` bytes) with the given index and `len` canonical permission strings
+    //
+    // `perm_lens[i]` is the length of `perms[i]`. If `perm_lens` is NULL, every permission must be NUL terminated. Empty permissions are skipped.
+    // Returns the handle of the new position, or `KITTYCAT_POSITION_HANDLE_INVALID` if a position with the same id is already registered
+    size_t kittycat_position_registry_add(
+        struct kittycat_position_registry *registry,
+        const char *const id,
+        const size_t id_len,
+        const int32_t index,
+        const char *const *perms,
+        const size_t *perm_lens,
+        const size_t len);
+
+    // Replaces the index and permissions of the position behind `handle`, taking the same arguments as `kittycat_position_registry_add`
+    //
+    // The position is changed in place, so every StaffKittycatPermissions holding it sees the new definition. Resolved permissions cached
+    // elsewhere are not touched (see `kittycat_resolve_cache_invalidate_position` and `kittycat_resolve_tracker_update_position`).
+    // Returns false if the handle is invalid
+    bool kittycat_position_registry_update(
+        struct kittycat_position_registry *registry,
+        const size_t handle,
+        const int32_t index,
+        const char *const *perms,
+        const size_t *perm_lens,
+        const size_t len);
+
+    // Returns the handle of the position `id` (`id_len` bytes), or `KITTYCAT_POSITION_HANDLE_INVALID` if it is not registered
+    size_t kittycat_position_registry_find(const struct kittycat_position_registry *const registry, const char *const id, const size_t id_len);
+
+    // Returns the position behind `handle`, or NULL if the handle is invalid. The position is owned by the registry and must not be modified
+    const struct KittycatPartialStaffPosition *kittycat_position_registry_get(const struct kittycat_position_registry *const registry, const size_t handle);
+
+    // Adds the registered position behind `handle` to the user positions of `sp` without copying it
+    //
+    // Freeing `sp` leaves the position alone, so the registry must outlive `sp`. Returns false if the handle is invalid
+    bool kittycat_staff_permissions_add_position(struct StaffKittycatPermissions *sp, const struct kittycat_position_registry *const registry, const size_t handle);
+
+    // Frees the kittycat_position_registry and every position in it
+    void kittycat_position_registry_free(struct kittycat_position_registry *registry);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_POSITION_REGISTRY_H
@@ -0,0 +1,200 @@
+// sysconf(_SC_NPROCESSORS_ONLN) and pthreads are POSIX, which strict C99 builds hide unless asked for
+#define _POSIX_C_SOURCE 200809L
+
+#include "resolve_batch.h"
+#include "arena.h"
+#include "internal.h"
+#include <pthread.h>
+#include <unistd.h>
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_resolve_batch_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+// Number of staff members a worker takes from its share at once
+#define __KITTYCAT_BATCH_CHUNK 16
+// Smallest share worth starting a thread for
+#define __KITTYCAT_BATCH_MIN_SHARE 64
+// Chunk size of the scratch arena of a worker
+#define __KITTYCAT_BATCH_SCRATCH_SIZE 4096
+
+struct __KittycatBatch;
+
+// A thread of a batch resolve. `next` and `end` are the remaining share of the worker and are guarded by `lock`
+struct __KittycatBatchWorker
+{
+    struct __KittycatBatch *batch;
+    size_t id;
+    pthread_t thread;
+    bool started;
+
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+
+    struct kittycat_arena *scratch;
+    // The map the forward engine resolves in, emptied in place between staff members. NULL for the reverse engine
+    struct __KittycatOrderedPermissionMap *opm;
+};
+
+struct __KittycatBatch
+{
+    const struct StaffKittycatPermissions *const *sp;
+    struct KittycatPermissionList **out;
+    uint32_t flags;
+
+    struct __KittycatBatchWorker *workers;
+    size_t len;
+};
+
+// Takes the next chunk of the share of `w`, returning false if it is empty
+bool __kittycat_batch_take(struct __KittycatBatchWorker *w, size_t *begin, size_t *end)
+{
+    pthread_mutex_lock(&w->lock);
+    bool found = w->next < w->end;
+    if (found)
+    {
+        *begin = w->next;
+        *end = w->end - w->next > __KITTYCAT_BATCH_CHUNK ? w->next + __KITTYCAT_BATCH_CHUNK : w->end;
+        w->next = *end;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return found;
+}
+
+// Moves the upper half of the remaining share of another worker to the (empty) share of `w`, returning false if every share is empty
+bool __kittycat_batch_steal(struct __KittycatBatchWorker *w)
+{
+    struct __KittycatBatch *batch = w->batch;
+    for (size_t k = 1; k < batch->len; k++)
+    {
+        struct __KittycatBatchWorker *victim = &batch->workers[(w->id + k) % batch->len];
+
+        // Only one lock is held at a time, so workers stealing from each other cannot deadlock
+        pthread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->next;
+        size_t stolen = remaining - remaining / 2;
+        size_t begin = victim->end - stolen;
+        size_t end = victim->end;
+        victim->end = begin;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (stolen > 0)
+        {
+            pthread_mutex_lock(&w->lock);
+            w->next = begin;
+            w->end = end;
+            pthread_mutex_unlock(&w->lock);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void *__kittycat_batch_worker_run(void *arg)
+{
+    struct __KittycatBatchWorker *w = arg;
+    struct __KittycatBatch *batch = w->batch;
+
+    size_t begin, end;
+    for (;;)
+    {
+        // Work only ever moves to the share of a live thief, which handles it itself, so the worker can stop once it finds nothing to steal
+        if (!__kittycat_batch_take(w, &begin, &end))
+        {
+            if (!__kittycat_batch_steal(w))
+            {
+                break;
+            }
+            continue;
+        }
+
+        for (size_t i = begin; i < end; i++)
+        {
+            batch->out[i] = __kittycat_staff_permissions_resolve(batch->sp[i], NULL, w->scratch, w->opm, batch->flags);
+            kittycat_arena_reset(w->scratch);
+        }
+    }
+
+    return NULL;
+}
+
+size_t kittycat_staff_permissions_resolve_batch(
+    const struct StaffKittycatPermissions *const *sp,
+    const size_t n,
+    struct KittycatPermissionList **out,
+    const struct KittycatResolveBatchOptions *const opts)
+{
+    size_t threads = opts != NULL ? opts->threads : 0;
+    if (threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+
+    size_t maxThreads = (n + __KITTYCAT_BATCH_MIN_SHARE - 1) / __KITTYCAT_BATCH_MIN_SHARE;
+    if (threads > maxThreads)
+    {
+        threads = maxThreads > 0 ? maxThreads : 1;
+    }
+
+    struct __KittycatBatch batch = {sp, out, opts != NULL ? opts->flags : KITTYCAT_RESOLVE_FLAGS_NONE, NULL, threads};
+    batch.workers = __kittycat_malloc(threads * sizeof(struct __KittycatBatchWorker));
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        struct __KittycatBatchWorker *w = &batch.workers[i];
+        w->batch = &batch;
+        w->id = i;
+        w->started = false;
+        pthread_mutex_init(&w->lock, NULL);
+        w->next = n * i / threads;
+        w->end = n * (i + 1) / threads;
+        w->scratch = kittycat_arena_new(__KITTYCAT_BATCH_SCRATCH_SIZE);
+        w->opm = (batch.flags & KITTYCAT_RESOLVE_FLAGS_REVERSE) ? NULL : __kittycat_ordered_permission_map_new();
+    }
+
+    // The calling thread is worker 0. If a thread cannot be started, its share is stolen by the others
+    size_t tookPart = 1;
+    for (size_t i = 1; i < threads; i++)
+    {
+        struct __KittycatBatchWorker *w = &batch.workers[i];
+        w->started = pthread_create(&w->thread, NULL, __kittycat_batch_worker_run, w) == 0;
+        if (w->started)
+        {
+            tookPart++;
+        }
+    }
+
+    __kittycat_batch_worker_run(&batch.workers[0]);
+
+    // Every thread must be done before any lock goes away, as a thread still stealing locks the share of every other worker
+    for (size_t i = 0; i < threads; i++)
+    {
+        if (batch.workers[i].started)
+        {
+            pthread_join(batch.workers[i].thread, NULL);
+        }
+    }
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_mutex_destroy(&batch.workers[i].lock);
+        kittycat_arena_free(batch.workers[i].scratch);
+        __kittycat_ordered_permission_map_free(batch.workers[i].opm);
+    }
+
+    __kittycat_free(batch.workers);
+    return tookPart;
+}
@@ -0,0 +1,51 @@
+#ifndef KITTYCAT_RESOLVE_BATCH_H
+#define KITTYCAT_RESOLVE_BATCH_H
+
+#include "perms.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator for the kittycat batch resolver
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_resolve_batch_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // Options of `kittycat_staff_permissions_resolve_batch`
+    struct KittycatResolveBatchOptions
+    {
+        // Number of threads resolving, including the calling thread. 0 uses one thread per online CPU
+        size_t threads;
+        // Bitwise OR of KittycatResolveFlags applied to every resolve
+        uint32_t flags;
+    };
+
+    // Resolves the KittycatPermissions of `n` staff members in parallel, storing those of `sp[i]` in `out[i]`
+    //
+    // The staff members are split between the threads, each working through its own share in small chunks and stealing half of the
+    // remaining share of another thread once done, so a few slow staff members do not hold up the whole batch. Every thread keeps its own
+    // scratch space for the duration of the batch, including the map of the default engine, so it resolves without setting one up per
+    // staff member.
+    //
+    // Every allocation goes through the allocator hooks, which must therefore be thread-safe (the default libc allocator is). The staff
+    // members must not be modified while the batch runs. `opts` may be NULL for the defaults. Returns the number of threads that took part,
+    // which is lower than requested for small batches or if threads could not be started
+    size_t kittycat_staff_permissions_resolve_batch(
+        const struct StaffKittycatPermissions *const *sp,
+        const size_t n,
+        struct KittycatPermissionList **out,
+        const struct KittycatResolveBatchOptions *const opts);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_RESOLVE_BATCH_H
@@ -0,0 +1,327 @@
+#include "resolve_cache.h"
+#include "hashmap.h"
+#include "internal.h"
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_resolve_cache_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+struct KittycatResolvedPermissions *kittycat_resolved_permissions_retain(struct KittycatResolvedPermissions *rp)
+{
+    rp->__refs++;
+    return rp;
+}
+
+void kittycat_resolved_permissions_release(struct KittycatResolvedPermissions *rp)
+{
+    if (rp == NULL)
+    {
+        return;
+    }
+
+    rp->__refs--;
+    if (rp->__refs == 0)
+    {
+        kittycat_permission_list_free(rp->perms);
+        __kittycat_free(rp);
+    }
+}
+
+// A cached resolve. Entries form a doubly linked list from the most to the least recently used one
+struct __KittycatResolveCacheEntry
+{
+    uint64_t hash;
+    // The key of the entry (see `__kittycat_resolve_cache_key`)
+    uint8_t *key;
+    size_t key_len;
+    struct KittycatResolvedPermissions *resolved;
+
+    struct __KittycatResolveCacheEntry *prev;
+    struct __KittycatResolveCacheEntry *next;
+};
+
+// The kittycat_hashmap of a kittycat_resolve_cache only holds pointers to the entries
+struct __KittycatResolveCacheSlot
+{
+    struct __KittycatResolveCacheEntry *entry;
+};
+
+uint64_t __kittycat_resolve_cache_slot_hash(const void *item, uint64_t seed0, uint64_t seed1)
+{
+    const struct __KittycatResolveCacheSlot *slot = item;
+    return slot->entry->hash;
+}
+
+int __kittycat_resolve_cache_slot_compare(const void *a, const void *b, void *udata)
+{
+    const struct __KittycatResolveCacheEntry *ea = ((const struct __KittycatResolveCacheSlot *)a)->entry;
+    const struct __KittycatResolveCacheEntry *eb = ((const struct __KittycatResolveCacheSlot *)b)->entry;
+    return ea->key_len == eb->key_len && memcmp(ea->key, eb->key, ea->key_len) == 0 ? 0 : 1;
+}
+
+struct kittycat_resolve_cache *kittycat_resolve_cache_new(const size_t capacity)
+{
+    struct kittycat_resolve_cache *cache = __kittycat_malloc(sizeof(struct kittycat_resolve_cache));
+    cache->capacity = capacity > 0 ? capacity : 1;
+    cache->len = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->__entries = kittycat_hashmap_new(sizeof(struct __KittycatResolveCacheSlot), 0, 0, 0, __kittycat_resolve_cache_slot_hash, __kittycat_resolve_cache_slot_compare, NULL, NULL);
+    cache->__lru_head = NULL;
+    cache->__lru_tail = NULL;
+    return cache;
+}
+
+// Appends `len` bytes to the key being built in `*key`, growing it as needed. `*key` starts out as the stack buffer `stack_key`
+void __kittycat_resolve_cache_key_push(uint8_t **key, size_t *key_len, size_t *key_cap, uint8_t *stack_key, const void *data, const size_t len)
+{
+    if (*key_len + len > *key_cap)
+    {
+        size_t cap = *key_cap * 2;
+        while (cap < *key_len + len)
+        {
+            cap *= 2;
+        }
+
+        if (*key == stack_key)
+        {
+            *key = __kittycat_malloc(cap);
+            memcpy(*key, stack_key, *key_len);
+        }
+        else
+        {
+            *key = __kittycat_realloc(*key, cap);
+        }
+        *key_cap = cap;
+    }
+
+    memcpy(*key + *key_len, data, len);
+    *key_len += len;
+}
+
+#define __KITTYCAT_RESOLVE_CACHE_STACK_KEY 256
+
+// Builds the cache key of `sp` into `*key`, which initially points to the stack buffer `stack_key` of __KITTYCAT_RESOLVE_CACHE_STACK_KEY bytes
+//
+// The key holds the length prefixed id and the index of every position in the order the positions are applied in, followed by the packed
+// perm overrides. The index is needed as it decides whether a position is applied before or after the perm overrides
+size_t __kittycat_resolve_cache_key(const struct StaffKittycatPermissions *const sp, uint8_t **key, uint8_t *stack_key)
+{
+    size_t key_len = 0;
+    size_t key_cap = __KITTYCAT_RESOLVE_CACHE_STACK_KEY;
+
+    // Order the positions the same way the resolver does
+    size_t n = sp->user_positions->len;
+    struct KittycatPartialStaffPosition *stack_positions[32];
+    struct KittycatPartialStaffPosition **positions = n <= 16 ? stack_positions : __kittycat_malloc(2 * n * sizeof(struct KittycatPartialStaffPosition *));
+    memcpy(positions, sp->user_positions->positions, n * sizeof(struct KittycatPartialStaffPosition *));
+    __kittycat_partial_staff_positions_sort(positions, positions + n, n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t id_len = (uint32_t)positions[i]->id->len;
+        __kittycat_resolve_cache_key_push(key, &key_len, &key_cap, stack_key, &id_len, sizeof(uint32_t));
+        __kittycat_resolve_cache_key_push(key, &key_len, &key_cap, stack_key, positions[i]->id->str, id_len);
+        __kittycat_resolve_cache_key_push(key, &key_len, &key_cap, stack_key, &positions[i]->index, sizeof(int32_t));
+    }
+
+    if (positions != stack_positions)
+    {
+        __kittycat_free(positions);
+    }
+
+    // Position ids can never be this long, so this cleanly separates the ids from the perm overrides
+    uint32_t separator = UINT32_MAX;
+    __kittycat_resolve_cache_key_push(key, &key_len, &key_cap, stack_key, &separator, sizeof(uint32_t));
+
+    for (size_t i = 0; i < sp->perm_overrides->len; i++)
+    {
+        uint64_t packed = kittycat_permission_pack(sp->perm_overrides->perms[i]);
+        __kittycat_resolve_cache_key_push(key, &key_len, &key_cap, stack_key, &packed, sizeof(uint64_t));
+    }
+
+    return key_len;
+}
+
+// Unlinks `entry` from the LRU list of the cache
+void __kittycat_resolve_cache_unlink(struct kittycat_resolve_cache *cache, struct __KittycatResolveCacheEntry *entry)
+{
+    if (entry->prev != NULL)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        cache->__lru_head = entry->next;
+    }
+
+    if (entry->next != NULL)
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        cache->__lru_tail = entry->prev;
+    }
+}
+
+// Links `entry` as the most recently used entry of the cache
+void __kittycat_resolve_cache_link_head(struct kittycat_resolve_cache *cache, struct __KittycatResolveCacheEntry *entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->__lru_head;
+    if (cache->__lru_head != NULL)
+    {
+        cache->__lru_head->prev = entry;
+    }
+    else
+    {
+        cache->__lru_tail = entry;
+    }
+    cache->__lru_head = entry;
+}
+
+// Removes `entry` from the cache and frees it
+void __kittycat_resolve_cache_drop(struct kittycat_resolve_cache *cache, struct __KittycatResolveCacheEntry *entry)
+{
+    struct __KittycatResolveCacheSlot slot = {entry};
+    kittycat_hashmap_delete(cache->__entries, &slot);
+    __kittycat_resolve_cache_unlink(cache, entry);
+    cache->len--;
+
+    kittycat_resolved_permissions_release(entry->resolved);
+    __kittycat_free(entry->key);
+    __kittycat_free(entry);
+}
+
+struct KittycatResolvedPermissions *kittycat_resolve_cache_get(struct kittycat_resolve_cache *cache, const struct StaffKittycatPermissions *const sp)
+{
+    uint8_t stack_key[__KITTYCAT_RESOLVE_CACHE_STACK_KEY];
+    uint8_t *key = stack_key;
+    size_t key_len = __kittycat_resolve_cache_key(sp, &key, stack_key);
+
+    struct __KittycatResolveCacheEntry probe;
+    probe.hash = kittycat_hashmap_xxhash3(key, key_len, 0, 0);
+    probe.key = key;
+    probe.key_len = key_len;
+    struct __KittycatResolveCacheSlot probe_slot = {&probe};
+
+    const struct __KittycatResolveCacheSlot *found = kittycat_hashmap_get(cache->__entries, &probe_slot);
+    if (found != NULL)
+    {
+        cache->hits++;
+        if (key != stack_key)
+        {
+            __kittycat_free(key);
+        }
+
+        // Move the entry to the front of the LRU list
+        __kittycat_resolve_cache_unlink(cache, found->entry);
+        __kittycat_resolve_cache_link_head(cache, found->entry);
+        return kittycat_resolved_permissions_retain(found->entry->resolved);
+    }
+
+    cache->misses++;
+
+    struct KittycatResolvedPermissions *resolved = __kittycat_malloc(sizeof(struct KittycatResolvedPermissions));
+    resolved->perms = kittycat_staff_permissions_resolve(sp);
+    resolved->__refs = 1; // The reference of the cache
+
+    struct __KittycatResolveCacheEntry *entry = __kittycat_malloc(sizeof(struct __KittycatResolveCacheEntry));
+    entry->hash = probe.hash;
+    entry->key_len = key_len;
+    if (key == stack_key)
+    {
+        entry->key = __kittycat_malloc(key_len > 0 ? key_len : 1);
+        memcpy(entry->key, stack_key, key_len);
+    }
+    else
+    {
+        entry->key = key; // Take over the heap allocated key
+    }
+    entry->resolved = resolved;
+
+    if (cache->len == cache->capacity)
+    {
+        __kittycat_resolve_cache_drop(cache, cache->__lru_tail);
+    }
+
+    struct __KittycatResolveCacheSlot slot = {entry};
+    kittycat_hashmap_set(cache->__entries, &slot);
+    __kittycat_resolve_cache_link_head(cache, entry);
+    cache->len++;
+
+    return kittycat_resolved_permissions_retain(resolved);
+}
+
+// Returns whether the cache key `key` includes the position `id`
+bool __kittycat_resolve_cache_key_has_position(const uint8_t *key, const size_t key_len, const char *const id, const size_t len)
+{
+    size_t i = 0;
+    while (i + sizeof(uint32_t) <= key_len)
+    {
+        uint32_t id_len;
+        memcpy(&id_len, key + i, sizeof(uint32_t));
+        if (id_len == UINT32_MAX)
+        {
+            return false; // Reached the perm overrides
+        }
+        i += sizeof(uint32_t);
+
+        if (id_len == len && memcmp(key + i, id, len) == 0)
+        {
+            return true;
+        }
+        i += id_len + sizeof(int32_t);
+    }
+
+    return false;
+}
+
+size_t kittycat_resolve_cache_invalidate_position(struct kittycat_resolve_cache *cache, const char *const id, const size_t len)
+{
+    size_t dropped = 0;
+    struct __KittycatResolveCacheEntry *entry = cache->__lru_head;
+    while (entry != NULL)
+    {
+        struct __KittycatResolveCacheEntry *next = entry->next;
+        if (__kittycat_resolve_cache_key_has_position(entry->key, entry->key_len, id, len))
+        {
+            __kittycat_resolve_cache_drop(cache, entry);
+            dropped++;
+        }
+        entry = next;
+    }
+
+    return dropped;
+}
+
+void kittycat_resolve_cache_clear(struct kittycat_resolve_cache *cache)
+{
+    while (cache->__lru_head != NULL)
+    {
+        __kittycat_resolve_cache_drop(cache, cache->__lru_head);
+    }
+}
+
+void kittycat_resolve_cache_free(struct kittycat_resolve_cache *cache)
+{
+    if (cache == NULL)
+    {
+        return;
+    }
+
+    kittycat_resolve_cache_clear(cache);
+    kittycat_hashmap_free(cache->__entries);
+    __kittycat_free(cache);
+}
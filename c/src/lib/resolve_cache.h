@@ -0,0 +1,84 @@
+#ifndef KITTYCAT_RESOLVE_CACHE_H
+#define KITTYCAT_RESOLVE_CACHE_H
+
+#include "perms.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator for the kittycat resolve cache
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_resolve_cache_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // A reference counted, shared set of resolved KittycatPermissions
+    struct KittycatResolvedPermissions
+    {
+        // The resolved KittycatPermissions. These are shared and must not be modified
+        struct KittycatPermissionList *perms;
+
+        // Internal
+        size_t __refs;
+    };
+
+    // Takes another reference to `rp`
+    struct KittycatResolvedPermissions *kittycat_resolved_permissions_retain(struct KittycatResolvedPermissions *rp);
+
+    // Drops a reference to `rp`, freeing it once the last reference is gone
+    void kittycat_resolved_permissions_release(struct KittycatResolvedPermissions *rp);
+
+    // A memoizing cache of `kittycat_staff_permissions_resolve`, for when many staff members share the same combination of positions
+    //
+    // Entries are keyed by the ids and indexes of the positions of a staff member in the order they are applied in (which, as long as no two
+    // positions share an index, is simply the sorted set of positions) plus the packed perm overrides. The permissions of a position are not
+    // part of the key, so `kittycat_resolve_cache_invalidate_position` must be called whenever the definition of a position changes.
+    // The least recently used entry is evicted once the cache is full. A kittycat_resolve_cache is not thread-safe
+    struct kittycat_resolve_cache
+    {
+        // Maximum number of cached entries
+        size_t capacity;
+        // Number of cached entries
+        size_t len;
+
+        // Statistics
+        uint64_t hits;
+        uint64_t misses;
+
+        // Internal
+        struct kittycat_hashmap *__entries;
+        struct __KittycatResolveCacheEntry *__lru_head;
+        struct __KittycatResolveCacheEntry *__lru_tail;
+    };
+
+    // Creates a new kittycat_resolve_cache holding at most `capacity` (at least 1) entries
+    struct kittycat_resolve_cache *kittycat_resolve_cache_new(const size_t capacity);
+
+    // Returns the resolved KittycatPermissions of `sp`, resolving and caching them on a miss
+    //
+    // The caller owns a reference to the returned KittycatResolvedPermissions and must drop it with `kittycat_resolved_permissions_release`
+    struct KittycatResolvedPermissions *kittycat_resolve_cache_get(struct kittycat_resolve_cache *cache, const struct StaffKittycatPermissions *const sp);
+
+    // Drops every cached entry including the position `id` (`len` bytes), returning the number of entries dropped
+    //
+    // This walks every cached entry and is meant for the rare case of a position being edited
+    size_t kittycat_resolve_cache_invalidate_position(struct kittycat_resolve_cache *cache, const char *const id, const size_t len);
+
+    // Drops every cached entry. The hit and miss counters are kept
+    void kittycat_resolve_cache_clear(struct kittycat_resolve_cache *cache);
+
+    // Frees the kittycat_resolve_cache. KittycatResolvedPermissions still referenced by callers stay valid
+    void kittycat_resolve_cache_free(struct kittycat_resolve_cache *cache);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_RESOLVE_CACHE_H
@@ -0,0 +1,430 @@
+#include "resolve_tracker.h"
+#include "internal.h"
+#include <stdlib.h>
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_resolve_tracker_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+// A tracked staff member
+struct __KittycatTrackedUser
+{
+    struct StaffKittycatPermissions *sp;
+    // The perm overrides of `sp` as a position, referenced by `ordered`
+    struct KittycatPartialStaffPosition overrides;
+    // The positions of `sp` in the order they are applied in
+    struct KittycatPartialStaffPositionList ordered;
+
+    // The resolved entries, ordered by append time, and the KittycatPermissions built from them
+    struct __KittycatResolvedEntry *entries;
+    size_t len;
+    struct KittycatPermissionList *perms;
+};
+
+// The users holding a registered position
+struct __KittycatTrackerDependents
+{
+    size_t *users;
+    size_t len;
+    size_t cap;
+};
+
+// A KittycatPermission of a position, for grouping the KittycatPermissions of a position by namespace
+struct __KittycatTrackerNamespaceEntry
+{
+    uint32_t namespace_atom;
+    uint32_t at;
+};
+
+int __kittycat_tracker_namespace_entry_compare(const void *a, const void *b)
+{
+    const struct __KittycatTrackerNamespaceEntry *ea = a;
+    const struct __KittycatTrackerNamespaceEntry *eb = b;
+    if (ea->namespace_atom != eb->namespace_atom)
+    {
+        return ea->namespace_atom < eb->namespace_atom ? -1 : 1;
+    }
+    return ea->at < eb->at ? -1 : (ea->at > eb->at ? 1 : 0);
+}
+
+struct kittycat_resolve_tracker *kittycat_resolve_tracker_new(struct kittycat_position_registry *registry)
+{
+    struct kittycat_resolve_tracker *tracker = __kittycat_malloc(sizeof(struct kittycat_resolve_tracker));
+    tracker->len = 0;
+    tracker->full_resolves = 0;
+    tracker->partial_resolves = 0;
+    tracker->__registry = registry;
+    tracker->__cap = 8;
+    tracker->__users = __kittycat_malloc(tracker->__cap * sizeof(struct __KittycatTrackedUser *));
+    tracker->__dependents = NULL;
+    tracker->__dependents_len = 0;
+    return tracker;
+}
+
+// Replaces the resolved entries of `user` (taking ownership of `entries`), returning whether the resolved KittycatPermissions changed
+bool __kittycat_tracked_user_set_entries(struct __KittycatTrackedUser *user, struct __KittycatResolvedEntry *entries, const size_t len)
+{
+    bool changed = user->perms == NULL || user->len != len;
+    for (size_t i = 0; i < len && !changed; i++)
+    {
+        changed = user->entries[i].packed != entries[i].packed;
+    }
+
+    if (user->entries != NULL)
+    {
+        __kittycat_free(user->entries);
+    }
+    user->entries = entries;
+    user->len = len;
+
+    if (!changed)
+    {
+        return false;
+    }
+
+    kittycat_permission_list_free(user->perms);
+    user->perms = kittycat_permission_list_new();
+    for (size_t i = 0; i < len; i++)
+    {
+        kittycat_permission_list_add(user->perms, __kittycat_new_permission_from_atoms(
+                                                      KITTYCAT_PACKED_PERMISSION_NAMESPACE(entries[i].packed),
+                                                      KITTYCAT_PACKED_PERMISSION_PERM(entries[i].packed),
+                                                      KITTYCAT_PACKED_PERMISSION_IS_NEGATOR(entries[i].packed)));
+    }
+    return true;
+}
+
+// Orders the positions of `user` and fully resolves them
+bool __kittycat_tracked_user_resolve(struct __KittycatTrackedUser *user)
+{
+    if (user->ordered.positions != NULL)
+    {
+        __kittycat_free(user->ordered.positions);
+    }
+    __kittycat_staff_permissions_order_positions(user->sp, NULL, KITTYCAT_RESOLVE_FLAGS_NONE, &user->overrides, &user->ordered);
+
+    size_t len = 0;
+    struct __KittycatResolvedEntry *entries = __kittycat_staff_permissions_resolve_entries(&user->ordered, NULL, 0, &len);
+    return __kittycat_tracked_user_set_entries(user, entries, len);
+}
+
+size_t kittycat_resolve_tracker_add_user(struct kittycat_resolve_tracker *tracker, struct StaffKittycatPermissions *sp)
+{
+    struct __KittycatTrackedUser *user = __kittycat_malloc(sizeof(struct __KittycatTrackedUser));
+    user->sp = sp;
+    user->overrides = __kittycat_perm_overrides_position(sp);
+    user->ordered.positions = NULL;
+    user->ordered.len = 0;
+    user->entries = NULL;
+    user->len = 0;
+    user->perms = NULL;
+    __kittycat_tracked_user_resolve(user);
+
+    if (tracker->len == tracker->__cap)
+    {
+        tracker->__cap *= 2;
+        tracker->__users = __kittycat_realloc(tracker->__users, tracker->__cap * sizeof(struct __KittycatTrackedUser *));
+    }
+
+    size_t handle = tracker->len;
+    tracker->__users[handle] = user;
+    tracker->len++;
+
+    struct kittycat_position_registry *registry = tracker->__registry;
+    if (tracker->__dependents_len < registry->len)
+    {
+        tracker->__dependents = __kittycat_realloc(tracker->__dependents, registry->len * sizeof(struct __KittycatTrackerDependents));
+        for (size_t i = tracker->__dependents_len; i < registry->len; i++)
+        {
+            tracker->__dependents[i].users = NULL;
+            tracker->__dependents[i].len = 0;
+            tracker->__dependents[i].cap = 0;
+        }
+        tracker->__dependents_len = registry->len;
+    }
+
+    for (size_t i = 0; i < sp->user_positions->len; i++)
+    {
+        struct KittycatPartialStaffPosition *pos = sp->user_positions->positions[i];
+        if (!pos->__shared)
+        {
+            continue;
+        }
+
+        size_t posHandle = kittycat_position_registry_find(registry, pos->id->str, pos->id->len);
+        if (posHandle == KITTYCAT_POSITION_HANDLE_INVALID || kittycat_position_registry_get(registry, posHandle) != pos)
+        {
+            continue;
+        }
+
+        // Users are added in order, so a position held twice by the user shows up as the last dependent
+        struct __KittycatTrackerDependents *deps = &tracker->__dependents[posHandle];
+        if (deps->len > 0 && deps->users[deps->len - 1] == handle)
+        {
+            continue;
+        }
+
+        if (deps->len == deps->cap)
+        {
+            deps->cap = deps->cap > 0 ? deps->cap * 2 : 4;
+            deps->users = __kittycat_realloc(deps->users, deps->cap * sizeof(size_t));
+        }
+        deps->users[deps->len++] = handle;
+    }
+
+    return handle;
+}
+
+struct KittycatPermissionList *kittycat_resolve_tracker_get(const struct kittycat_resolve_tracker *const tracker, const size_t user)
+{
+    if (user >= tracker->len)
+    {
+        return NULL;
+    }
+
+    return tracker->__users[user]->perms;
+}
+
+// Groups the KittycatPermissions of `perms` by namespace, keeping their order within each namespace
+struct __KittycatTrackerNamespaceEntry *__kittycat_tracker_group_by_namespace(const struct KittycatPermissionList *const perms)
+{
+    struct __KittycatTrackerNamespaceEntry *grouped = __kittycat_malloc((perms->len + 1) * sizeof(struct __KittycatTrackerNamespaceEntry));
+    for (size_t i = 0; i < perms->len; i++)
+    {
+        grouped[i].namespace_atom = perms->perms[i]->namespace_atom;
+        grouped[i].at = (uint32_t)i;
+    }
+    qsort(grouped, perms->len, sizeof(struct __KittycatTrackerNamespaceEntry), __kittycat_tracker_namespace_entry_compare);
+    return grouped;
+}
+
+// Compares the old and new KittycatPermissions of a position namespace by namespace
+//
+// Namespaces whose entries differ are written to `touched` in ascending order and their count is returned. For every other entry of
+// `oldPerms`, `oldToNew` is set to the index of the same entry in `newPerms`
+size_t __kittycat_tracker_diff(const struct KittycatPermissionList *const oldPerms, const struct KittycatPermissionList *const newPerms, uint32_t *touched, uint32_t *oldToNew)
+{
+    struct __KittycatTrackerNamespaceEntry *oldGrouped = __kittycat_tracker_group_by_namespace(oldPerms);
+    struct __KittycatTrackerNamespaceEntry *newGrouped = __kittycat_tracker_group_by_namespace(newPerms);
+
+    size_t nTouched = 0;
+    size_t a = 0;
+    size_t b = 0;
+    while (a < oldPerms->len || b < newPerms->len)
+    {
+        uint32_t ns;
+        if (a == oldPerms->len)
+        {
+            ns = newGrouped[b].namespace_atom;
+        }
+        else if (b == newPerms->len || oldGrouped[a].namespace_atom < newGrouped[b].namespace_atom)
+        {
+            ns = oldGrouped[a].namespace_atom;
+        }
+        else
+        {
+            ns = newGrouped[b].namespace_atom;
+        }
+
+        size_t aEnd = a;
+        while (aEnd < oldPerms->len && oldGrouped[aEnd].namespace_atom == ns)
+        {
+            aEnd++;
+        }
+        size_t bEnd = b;
+        while (bEnd < newPerms->len && newGrouped[bEnd].namespace_atom == ns)
+        {
+            bEnd++;
+        }
+
+        bool same = aEnd - a == bEnd - b;
+        for (size_t k = 0; same && k < aEnd - a; k++)
+        {
+            const struct KittycatPermission *op = oldPerms->perms[oldGrouped[a + k].at];
+            const struct KittycatPermission *np = newPerms->perms[newGrouped[b + k].at];
+            same = op->perm_atom == np->perm_atom && op->negator == np->negator;
+        }
+
+        if (same)
+        {
+            for (size_t k = 0; k < aEnd - a; k++)
+            {
+                oldToNew[oldGrouped[a + k].at] = newGrouped[b + k].at;
+            }
+        }
+        else
+        {
+            touched[nTouched++] = ns;
+        }
+
+        a = aEnd;
+        b = bEnd;
+    }
+
+    __kittycat_free(oldGrouped);
+    __kittycat_free(newGrouped);
+    return nTouched;
+}
+
+// Re-resolves only the `nTouched` namespaces in `touched` for `user` after `pos` changed, moving the entries of `pos` in the other
+// namespaces to their new place
+bool __kittycat_tracked_user_resolve_partial(struct __KittycatTrackedUser *user, const struct KittycatPartialStaffPosition *const pos, const uint32_t *touched, const size_t nTouched, const uint32_t *oldToNew)
+{
+    size_t freshLen = 0;
+    struct __KittycatResolvedEntry *fresh = nTouched > 0 ? __kittycat_staff_permissions_resolve_entries(&user->ordered, touched, nTouched, &freshLen) : NULL;
+
+    size_t len = 0;
+    struct __KittycatResolvedEntry *entries = __kittycat_malloc((user->len + freshLen + 1) * sizeof(struct __KittycatResolvedEntry));
+    for (size_t i = 0; i < user->len; i++)
+    {
+        struct __KittycatResolvedEntry e = user->entries[i];
+        uint32_t ns = KITTYCAT_PACKED_PERMISSION_NAMESPACE(e.packed);
+        if (nTouched > 0 && bsearch(&ns, touched, nTouched, sizeof(uint32_t), __kittycat_atom_compare) != NULL)
+        {
+            continue;
+        }
+
+        size_t rank = (size_t)(e.ts >> 32);
+        if (user->ordered.positions[rank] == pos)
+        {
+            e.ts = __KITTYCAT_RESOLVED_TS(rank, oldToNew[(uint32_t)e.ts]);
+        }
+        entries[len++] = e;
+    }
+
+    if (fresh != NULL)
+    {
+        memcpy(entries + len, fresh, freshLen * sizeof(struct __KittycatResolvedEntry));
+        len += freshLen;
+        __kittycat_free(fresh);
+    }
+
+    qsort(entries, len, sizeof(struct __KittycatResolvedEntry), __kittycat_resolved_entry_ts_compare);
+    return __kittycat_tracked_user_set_entries(user, entries, len);
+}
+
+size_t kittycat_resolve_tracker_update_position(
+    struct kittycat_resolve_tracker *tracker,
+    const size_t handle,
+    const int32_t index,
+    const char *const *perms,
+    const size_t *perm_lens,
+    const size_t len,
+    size_t *changed)
+{
+    if (handle >= tracker->__registry->len)
+    {
+        return KITTYCAT_RESOLVE_TRACKER_USER_INVALID;
+    }
+
+    // Swap in the new definition by hand, as the old one is needed to find what changed
+    struct KittycatPartialStaffPosition *pos = tracker->__registry->__positions[handle];
+    struct KittycatPermissionList *oldPerms = pos->perms;
+    uint8_t *oldKinds = pos->__kinds;
+    bool full = pos->index != index;
+    pos->index = index;
+    __kittycat_position_registry_parse(pos, perms, perm_lens, len);
+
+    for (size_t i = 0; i < oldPerms->len && !full; i++)
+    {
+        full = (oldKinds[i] & __KITTYCAT_ENTRY_GLOBAL_CLEAR) != 0;
+    }
+    for (size_t i = 0; i < pos->perms->len && !full; i++)
+    {
+        full = (pos->__kinds[i] & __KITTYCAT_ENTRY_GLOBAL_CLEAR) != 0;
+    }
+
+    uint32_t *touched = NULL;
+    uint32_t *oldToNew = NULL;
+    size_t nTouched = 0;
+    if (!full)
+    {
+        touched = __kittycat_malloc((oldPerms->len + pos->perms->len + 1) * sizeof(uint32_t));
+        oldToNew = __kittycat_malloc((oldPerms->len + 1) * sizeof(uint32_t));
+        nTouched = __kittycat_tracker_diff(oldPerms, pos->perms, touched, oldToNew);
+    }
+
+    size_t nChanged = 0;
+    if (handle < tracker->__dependents_len)
+    {
+        struct __KittycatTrackerDependents *deps = &tracker->__dependents[handle];
+        for (size_t i = 0; i < deps->len; i++)
+        {
+            struct __KittycatTrackedUser *user = tracker->__users[deps->users[i]];
+
+            bool userChanged;
+            if (full)
+            {
+                userChanged = __kittycat_tracked_user_resolve(user);
+                tracker->full_resolves++;
+            }
+            else
+            {
+                userChanged = __kittycat_tracked_user_resolve_partial(user, pos, touched, nTouched, oldToNew);
+                tracker->partial_resolves++;
+            }
+
+            if (userChanged)
+            {
+                if (changed != NULL)
+                {
+                    changed[nChanged] = deps->users[i];
+                }
+                nChanged++;
+            }
+        }
+    }
+
+    if (!full)
+    {
+        __kittycat_free(touched);
+        __kittycat_free(oldToNew);
+    }
+    kittycat_permission_list_free(oldPerms);
+    __kittycat_free(oldKinds);
+
+    return nChanged;
+}
+
+void kittycat_resolve_tracker_free(struct kittycat_resolve_tracker *tracker)
+{
+    if (tracker == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < tracker->len; i++)
+    {
+        struct __KittycatTrackedUser *user = tracker->__users[i];
+        kittycat_staff_permissions_free(user->sp);
+        __kittycat_free(user->ordered.positions);
+        __kittycat_free(user->entries);
+        kittycat_permission_list_free(user->perms);
+        __kittycat_free(user);
+    }
+
+    for (size_t i = 0; i < tracker->__dependents_len; i++)
+    {
+        if (tracker->__dependents[i].users != NULL)
+        {
+            __kittycat_free(tracker->__dependents[i].users);
+        }
+    }
+
+    if (tracker->__dependents != NULL)
+    {
+        __kittycat_free(tracker->__dependents);
+    }
+    __kittycat_free(tracker->__users);
+    __kittycat_free(tracker);
+}
@@ -0,0 +1,84 @@
+#ifndef KITTYCAT_RESOLVE_TRACKER_H
+#define KITTYCAT_RESOLVE_TRACKER_H
+
+#include "perms.h"
+#include "position_registry.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator for the kittycat resolve tracker
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_resolve_tracker_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // Returned in place of a user handle when there is no such user
+#define KITTYCAT_RESOLVE_TRACKER_USER_INVALID ((size_t)-1)
+
+    // Keeps the resolved KittycatPermissions of many staff members up to date as the positions of a kittycat_position_registry change
+    //
+    // The tracker remembers which users hold which registered positions. When a position is edited through
+    // `kittycat_resolve_tracker_update_position`, only the users holding it are looked at and, since namespaces resolve independently of
+    // each other, only the namespaces whose entries in the position actually changed are resolved again. Changing the index of a position
+    // or adding/removing a `global.@clear` reorders or cuts off everything, in which case the affected users are fully resolved again.
+    // A kittycat_resolve_tracker is not thread-safe
+    struct kittycat_resolve_tracker
+    {
+        // Number of tracked users
+        size_t len;
+
+        // Statistics
+        uint64_t full_resolves;
+        uint64_t partial_resolves;
+
+        // Internal
+        struct kittycat_position_registry *__registry;
+        struct __KittycatTrackedUser **__users;
+        size_t __cap;
+        struct __KittycatTrackerDependents *__dependents;
+        size_t __dependents_len;
+    };
+
+    // Creates a new kittycat_resolve_tracker for the positions of `registry`, which must outlive the tracker
+    struct kittycat_resolve_tracker *kittycat_resolve_tracker_new(struct kittycat_position_registry *registry);
+
+    // Starts tracking the staff member `sp`, taking ownership of it, and returns its user handle
+    //
+    // Positions of `sp` added with `kittycat_staff_permissions_add_position` are tracked, any other position is assumed to never change.
+    // `sp` must not be modified afterwards
+    size_t kittycat_resolve_tracker_add_user(struct kittycat_resolve_tracker *tracker, struct StaffKittycatPermissions *sp);
+
+    // Returns the resolved KittycatPermissions of the user behind `user`, or NULL if the handle is invalid
+    //
+    // The list is owned by the tracker, must not be modified and stays valid until the permissions of the user change
+    struct KittycatPermissionList *kittycat_resolve_tracker_get(const struct kittycat_resolve_tracker *const tracker, const size_t user);
+
+    // Updates the registered position behind `handle` just like `kittycat_position_registry_update` and re-resolves the users holding it
+    //
+    // Unless `changed` is NULL, the handles of the users whose resolved KittycatPermissions changed are written to it, so it must have room
+    // for `tracker->len` handles. Returns the number of such users, or `KITTYCAT_RESOLVE_TRACKER_USER_INVALID` if the handle is invalid
+    size_t kittycat_resolve_tracker_update_position(
+        struct kittycat_resolve_tracker *tracker,
+        const size_t handle,
+        const int32_t index,
+        const char *const *perms,
+        const size_t *perm_lens,
+        const size_t len,
+        size_t *changed);
+
+    // Frees the kittycat_resolve_tracker along with every tracked StaffKittycatPermissions. The registry is left alone
+    void kittycat_resolve_tracker_free(struct kittycat_resolve_tracker *tracker);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_RESOLVE_TRACKER_H
@@ -0,0 +1,74 @@
+#include "resolver.h"
+#include "internal.h"
+
+static void *(*__kittycat_malloc)(size_t) = NULL;
+static void *(*__kittycat_realloc)(void *, size_t) = NULL;
+static void (*__kittycat_free)(void *) = NULL;
+
+void kittycat_resolver_set_allocator(
+    void *(*malloc)(size_t),
+    void *(*realloc)(void *, size_t),
+    void (*free)(void *))
+{
+    __kittycat_malloc = malloc;
+    __kittycat_realloc = realloc;
+    __kittycat_free = free;
+}
+
+struct kittycat_resolver *kittycat_resolver_new()
+{
+    struct kittycat_resolver *resolver = __kittycat_malloc(sizeof(struct kittycat_resolver));
+    resolver->resolves = 0;
+    resolver->__opm = __kittycat_ordered_permission_map_new();
+    resolver->__positions_cap = 16;
+    resolver->__positions = __kittycat_malloc(resolver->__positions_cap * sizeof(struct KittycatPartialStaffPosition *));
+    return resolver;
+}
+
+// Orders the positions of `sp` into the buffer of `resolver`, growing it if needed. `permOverridesPos` must outlive `out`
+void __kittycat_resolver_order_positions(struct kittycat_resolver *resolver, const struct StaffKittycatPermissions *const sp, struct KittycatPartialStaffPosition *permOverridesPos, struct KittycatPartialStaffPositionList *out)
+{
+    // Room for the positions, the perm overrides and as much scratch space for sorting them
+    size_t needed = 2 * (sp->user_positions->len + 1);
+    if (needed > resolver->__positions_cap)
+    {
+        while (resolver->__positions_cap < needed)
+        {
+            resolver->__positions_cap *= 2;
+        }
+        resolver->__positions = __kittycat_realloc(resolver->__positions, resolver->__positions_cap * sizeof(struct KittycatPartialStaffPosition *));
+    }
+
+    __kittycat_staff_permissions_order_positions_into(sp, KITTYCAT_RESOLVE_FLAGS_NONE, permOverridesPos, resolver->__positions, out);
+    resolver->resolves++;
+}
+
+struct KittycatPermissionList *kittycat_resolver_resolve(struct kittycat_resolver *resolver, const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena)
+{
+    struct KittycatPartialStaffPosition permOverridesPos = __kittycat_perm_overrides_position(sp);
+    struct KittycatPartialStaffPositionList userPositions;
+    __kittycat_resolver_order_positions(resolver, sp, &permOverridesPos, &userPositions);
+
+    return __kittycat_staff_permissions_resolve_forward_with(resolver->__opm, &userPositions, arena);
+}
+
+struct KittycatPermissionSet *kittycat_resolver_resolve_to_set(struct kittycat_resolver *resolver, const struct StaffKittycatPermissions *const sp)
+{
+    struct KittycatPartialStaffPosition permOverridesPos = __kittycat_perm_overrides_position(sp);
+    struct KittycatPartialStaffPositionList userPositions;
+    __kittycat_resolver_order_positions(resolver, sp, &permOverridesPos, &userPositions);
+
+    return __kittycat_staff_permissions_resolve_set_with(resolver->__opm, &userPositions);
+}
+
+void kittycat_resolver_free(struct kittycat_resolver *resolver)
+{
+    if (resolver == NULL)
+    {
+        return;
+    }
+
+    __kittycat_ordered_permission_map_free(resolver->__opm);
+    __kittycat_free(resolver->__positions);
+    __kittycat_free(resolver);
+}
@@ -0,0 +1,59 @@
+#ifndef KITTYCAT_RESOLVER_H
+#define KITTYCAT_RESOLVER_H
+
+#include "perms.h"
+#include "perm_index.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif // __cplusplus
+
+    // Sets the allocator for the kittycat resolver
+    //
+    // Note: it is recommended to use kittycat_set_allocator instead
+    void kittycat_resolver_set_allocator(
+        void *(*malloc)(size_t),
+        void *(*realloc)(void *, size_t),
+        void (*free)(void *));
+
+    // A reusable context for resolving the KittycatPermissions of many staff members one after another
+    //
+    // `kittycat_staff_permissions_resolve` sets up (and tears down) its scratch kittycat_hashmaps and arrays on every call. A kittycat_resolver
+    // keeps them between calls instead, emptying them in place, so once it has seen the largest staff member it is used for, resolving
+    // allocates nothing but the output. With an arena for the output, not even that. A kittycat_resolver is not thread-safe
+    struct kittycat_resolver
+    {
+        // Number of resolves done with this resolver
+        uint64_t resolves;
+
+        // Internal
+        struct __KittycatOrderedPermissionMap *__opm;
+        struct KittycatPartialStaffPosition **__positions;
+        size_t __positions_cap;
+    };
+
+    // Creates a new kittycat_resolver
+    struct kittycat_resolver *kittycat_resolver_new();
+
+    // Resolves the KittycatPermissions of `sp` exactly like `kittycat_staff_permissions_resolve`
+    //
+    // The result is allocated in `arena` unless it is NULL, in which case it must be freed with `kittycat_permission_list_free`
+    struct KittycatPermissionList *kittycat_resolver_resolve(struct kittycat_resolver *resolver, const struct StaffKittycatPermissions *const sp, struct kittycat_arena *arena);
+
+    // Resolves the KittycatPermissions of `sp` exactly like `kittycat_staff_permissions_resolve_to_set`
+    //
+    // After warm-up, the KittycatPermissionSet is the only allocation made
+    struct KittycatPermissionSet *kittycat_resolver_resolve_to_set(struct kittycat_resolver *resolver, const struct StaffKittycatPermissions *const sp);
+
+    // Frees the kittycat_resolver. Results returned by it stay valid
+    void kittycat_resolver_free(struct kittycat_resolver *resolver);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // KITTYCAT_RESOLVER_H
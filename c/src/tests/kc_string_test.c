@@ -1,8 +1,24 @@
+// pthreads are POSIX, which strict C99 builds hide unless asked for
+#define _POSIX_C_SOURCE 200809L
+
 #include "../lib/kc_string.h"
 #include "../lib/alloc.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+// Interns enough distinct strings to grow the atom array several times
+void *intern_many(void *arg)
+{
+    char buf[32];
+    for (int i = 0; i < 5000; i++)
+    {
+        int n = snprintf(buf, sizeof(buf), "%s%d", (const char *)arg, i);
+        kittycat_string_intern(buf, (size_t)n);
+    }
+    return NULL;
+}
+
 int main()
 {
     kittycat_set_allocator(malloc, realloc, free, memcpy);
@@ -76,4 +92,61 @@ int main()
     kittycat_string_free(s2);
     kittycat_string_free(s3);
     kittycat_string_free(s3_expected);
+
+    // Interning
+    if (kittycat_string_atom_lookup("global", 6) != KITTYCAT_ATOM_GLOBAL || kittycat_string_atom_lookup("*", 1) != KITTYCAT_ATOM_WILDCARD || kittycat_string_atom_lookup("@clear", 6) != KITTYCAT_ATOM_CLEAR)
+    {
+        printf("ERROR: reserved atoms not found before first intern\n");
+        return 1;
+    }
+
+    if (kittycat_string_atom_lookup("rpc", 3) != KITTYCAT_ATOM_NONE)
+    {
+        printf("ERROR: rpc should not be interned yet\n");
+        return 1;
+    }
+
+    uint32_t rpc = kittycat_string_intern("rpc.test", 3); // Not NUL terminated after "rpc"
+    uint32_t rpc2 = kittycat_string_intern("rpc", 3);
+    uint32_t apps = kittycat_string_intern("apps", 4);
+    uint32_t global = kittycat_string_intern("global", 6);
+
+    if (rpc != rpc2 || rpc == apps || global != KITTYCAT_ATOM_GLOBAL || kittycat_string_atom_lookup("rpc", 3) != rpc)
+    {
+        printf("ERROR: rpc=%u, rpc2=%u, apps=%u, global=%u\n", rpc, rpc2, apps, global);
+        return 1;
+    }
+
+    struct kittycat_string *rpc_str = kittycat_string_atom_str(rpc);
+    if (rpc_str->len != 3 || strcmp(rpc_str->str, "rpc") != 0)
+    {
+        printf("ERROR: atom %u resolved to %s\n", rpc, rpc_str->str);
+        return 1;
+    }
+
+    printf("Interned atoms: %zu\n", kittycat_string_interner_len());
+
+    // kittycat_string_atom_str does not lock, and must see a consistent atom array while other threads intern and grow it
+    pthread_t threads[2];
+    pthread_create(&threads[0], NULL, intern_many, "a");
+    pthread_create(&threads[1], NULL, intern_many, "b");
+    for (int i = 0; i < 20000; i++)
+    {
+        size_t len = kittycat_string_interner_len();
+        if (kittycat_string_atom_str((uint32_t)(len - 1)) == NULL || kittycat_string_atom_str(rpc) != rpc_str)
+        {
+            printf("ERROR: atom %zu not found while interning concurrently\n", len - 1);
+            return 1;
+        }
+    }
+    pthread_join(threads[0], NULL);
+    pthread_join(threads[1], NULL);
+
+    if (kittycat_string_atom_lookup("a4999", 5) == KITTYCAT_ATOM_NONE || kittycat_string_atom_lookup("b4999", 5) == KITTYCAT_ATOM_NONE)
+    {
+        printf("ERROR: concurrently interned strings not found\n");
+        return 1;
+    }
+
+    kittycat_string_interner_free();
 }
\ No newline at end of file
@@ -1,6 +1,14 @@
 #include "../lib/perms.h"
+#include "../lib/perm_index.h"
 #include "../lib/kc_string.h"
 #include "../lib/alloc.h"
+#include "../lib/arena.h"
+#include "../lib/position_registry.h"
+#include "../lib/resolve_cache.h"
+#include "../lib/resolve_tracker.h"
+#include "../lib/resolve_batch.h"
+#include "../lib/resolver.h"
+#include "../lib/patch_checker.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -10,6 +18,23 @@
 #define printf(fmt, ...)
 #endif
 
+// Number of allocations made through the kittycat allocator, used to check allocation-free code paths
+//
+// The hooks must be thread-safe as the batch tests allocate from several threads, hence the atomic increments
+size_t allocations = 0;
+
+void *counting_malloc(size_t size)
+{
+    __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void *counting_realloc(void *ptr, size_t size)
+{
+    __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+    return realloc(ptr, size);
+}
+
 #if defined(DECONSTRUCT_kittycat_permission_CHECKS)
 int deconstruct_kittycat_permission__test(char *perm)
 {
@@ -39,6 +64,20 @@ int deconstruct_kittycat_permission__test(char *perm)
 }
 #endif
 
+struct KittycatPermissionList *perm_list_from_strs(char **str, size_t len)
+{
+    struct KittycatPermissionList *perms = kittycat_permission_list_new();
+
+    for (size_t i = 0; i < len; i++)
+    {
+        struct kittycat_string *perm_str = kittycat_string_new(str[i], strlen(str[i]));
+        kittycat_permission_list_add(perms, kittycat_permission_new_from_str(perm_str));
+        kittycat_string_free(perm_str);
+    }
+
+    return perms;
+}
+
 bool has_perm_test_impl(char **str, char *perm, size_t len)
 {
     struct KittycatPermissionList *perms = kittycat_permission_list_new();
@@ -60,6 +99,81 @@ bool has_perm_test_impl(char **str, char *perm, size_t len)
 
     bool res = kittycat_has_perm(perms, p);
 
+    // The string based entry points must agree without allocating
+    size_t allocations_before = allocations;
+    if (kittycat_has_perm_cstr(perms, perm, strlen(perm)) != res || kittycat_has_perm_cstr_arr((const char *const *)str, NULL, len, perm, strlen(perm)) != res)
+    {
+        fprintf(stderr, "ERROR: string based has_perm disagrees for %s\n", perm);
+        exit(1);
+    }
+    if (allocations != allocations_before)
+    {
+        fprintf(stderr, "ERROR: string based has_perm allocated for %s\n", perm);
+        exit(1);
+    }
+
+    // The packed representation must agree with the pointer based one
+    struct KittycatPackedPermissionList *packed = kittycat_permission_list_pack(perms);
+    struct KittycatPermissionList *unpacked = kittycat_packed_permission_list_unpack(packed);
+    if (kittycat_packed_has_perm(packed, kittycat_permission_pack(p)) != res || !kittycat_permission_lists_equal(perms, unpacked))
+    {
+        fprintf(stderr, "ERROR: packed permission list disagrees for %s\n", perm);
+        exit(1);
+    }
+    kittycat_permission_list_free(unpacked);
+    kittycat_packed_permission_list_free(packed);
+
+    // So must the compiled permission set
+    struct KittycatPermissionSet *set = kittycat_permission_set_compile(perms);
+    if (kittycat_permission_set_has(set, p) != res)
+    {
+        fprintf(stderr, "ERROR: compiled permission set disagrees for %s\n", perm);
+        exit(1);
+    }
+    kittycat_permission_set_free(set);
+
+    // The SIMD column scans must agree at every SIMD level. Pad the list with unrelated permissions so that
+    // the checked permissions land in vector lanes and not just the scalar tail
+    struct KittycatPermissionList *padded = kittycat_permission_list_new();
+    for (size_t i = 0; i < 13 + perms->len + 9; i++)
+    {
+        if (i >= 13 && i < 13 + perms->len)
+        {
+            kittycat_permission_list_add(padded, kittycat_permission_unpack(kittycat_permission_pack(perms->perms[i - 13])));
+        }
+        else
+        {
+            kittycat_permission_list_add(padded, kittycat_permission_unpack(kittycat_permission_pack_str(i % 2 ? "~padding.*" : "padding.test", i % 2 ? 10 : 12)));
+        }
+    }
+
+    struct KittycatPermissionColumns *columns = kittycat_permission_columns_new(padded);
+    enum KittycatSimdLevel simd_level = kittycat_simd_level();
+    for (int level = KITTYCAT_SIMD_LEVEL_SCALAR; level <= (int)simd_level; level++)
+    {
+        kittycat_set_max_simd_level((enum KittycatSimdLevel)level);
+        if (kittycat_permission_columns_has_perm(columns, p) != res)
+        {
+            fprintf(stderr, "ERROR: permission columns disagree for %s at SIMD level %d\n", perm, level);
+            exit(1);
+        }
+    }
+    kittycat_set_max_simd_level(KITTYCAT_SIMD_LEVEL_AVX2);
+    kittycat_permission_columns_free(columns);
+    kittycat_permission_list_free(padded);
+
+    // And a bitset lowered through a schema holding the checked permission
+    const char *schema_perms[] = {"apps.other", perm, "rpc.test"};
+    struct KittycatPermissionSchema *schema = kittycat_permission_schema_new(schema_perms, 3);
+    struct KittycatPermissionBitset *bs = kittycat_permission_bitset_new(schema, perms);
+    if (kittycat_permission_bitset_has(bs, kittycat_permission_schema_index(schema, p)) != res)
+    {
+        fprintf(stderr, "ERROR: permission bitset disagrees for %s\n", perm);
+        exit(1);
+    }
+    kittycat_permission_bitset_free(bs);
+    kittycat_permission_schema_free(schema);
+
     kittycat_string_free(permlist_joined);
     kittycat_string_free(perm_str);
     kittycat_permission_free(p);
@@ -166,32 +280,1060 @@ int has_perm__test()
         return 1;
     }
 
-    if (!has_perm_test_impl((char *[]){"~apps.test", "global.*"}, "apps.test", 2))
+    if (!has_perm_test_impl((char *[]){"~apps.test", "global.*"}, "apps.test", 2))
+    {
+        printf("Expected true, got false\n");
+        return 1;
+    }
+
+    if (has_perm_test_impl((char *[]){"global.test", "~rpc.test"}, "rpc.test", 2))
+    {
+        printf("Expected false, got true\n");
+        return 1;
+    }
+
+    if (has_perm_test_impl((char *[]){"rpc.*", "~global.test"}, "rpc.test", 2))
+    {
+        printf("Expected false, got true\n");
+        return 1;
+    }
+
+    if (!has_perm_test_impl((char *[]){"rpc.*", "~global.test"}, "rpc.other", 2))
+    {
+        printf("Expected true, got false\n");
+        return 1;
+    }
+
+    // Namespaces and perms that were never interned can still be granted through global
+    struct KittycatPermissionList *global_test = perm_list_from_strs((char *[]){"global.test"}, 1);
+    bool uninterned_test = kittycat_has_perm_cstr(global_test, "uninterned_ns.test", 18);
+    bool uninterned_other = kittycat_has_perm_cstr(global_test, "uninterned_ns.uninterned_perm", 29);
+    kittycat_permission_list_free(global_test);
+
+    if (!uninterned_test || uninterned_other)
+    {
+        printf("Expected true and false, got %d and %d\n", uninterned_test, uninterned_other);
+        return 1;
+    }
+
+    return 0;
+}
+
+int permission_schema__test()
+{
+    FILE *manifest = tmpfile();
+    if (manifest == NULL)
+    {
+        printf("Skipping manifest test, no tmpfile\n");
+        return 0;
+    }
+
+    fputs("# Bot queue\n  rpc.ViewBotQueue  \nrpc.BotClaim\n\nrpc.BotClaim\napps.test\nglobal.test\n~apps.other", manifest);
+    rewind(manifest);
+
+    struct KittycatPermissionSchema *schema = kittycat_permission_schema_load(manifest);
+    fclose(manifest);
+
+    if (schema->len != 5)
+    {
+        printf("Expected 5 permissions in schema, got %zu\n", schema->len);
+        return 1;
+    }
+
+    struct KittycatPermissionList *manager = perm_list_from_strs((char *[]){"rpc.*", "apps.test", "~rpc.BotClaim"}, 3);
+    struct KittycatPermissionList *reviewer = perm_list_from_strs((char *[]){"rpc.ViewBotQueue"}, 1);
+    struct KittycatPermissionList *admin = perm_list_from_strs((char *[]){"global.*"}, 1);
+
+    struct KittycatPermissionBitset *manager_bs = kittycat_permission_bitset_new(schema, manager);
+    struct KittycatPermissionBitset *reviewer_bs = kittycat_permission_bitset_new(schema, reviewer);
+    struct KittycatPermissionBitset *admin_bs = kittycat_permission_bitset_new(schema, admin);
+
+    int rc = 0;
+    if (!kittycat_permission_bitset_contains(manager_bs, reviewer_bs) || kittycat_permission_bitset_contains(reviewer_bs, manager_bs))
+    {
+        printf("Expected manager to contain reviewer\n");
+        rc = 1;
+    }
+
+    if (!kittycat_permission_bitset_contains(admin_bs, manager_bs) || kittycat_permission_bitset_equal(admin_bs, manager_bs))
+    {
+        printf("Expected admin to contain manager\n");
+        rc = 1;
+    }
+
+    // ~rpc.BotClaim is negated, global.test and apps.other are not granted by rpc.*
+    if (!kittycat_permission_bitset_has(manager_bs, 0) || kittycat_permission_bitset_has(manager_bs, 1) || !kittycat_permission_bitset_has(manager_bs, 2) ||
+        kittycat_permission_bitset_has(manager_bs, 3) || kittycat_permission_bitset_has(manager_bs, 4))
+    {
+        printf("Unexpected manager bitset %llx\n", (unsigned long long)manager_bs->words[0]);
+        rc = 1;
+    }
+
+    kittycat_permission_bitset_free(manager_bs);
+    kittycat_permission_bitset_free(reviewer_bs);
+    kittycat_permission_bitset_free(admin_bs);
+    kittycat_permission_list_free(manager);
+    kittycat_permission_list_free(reviewer);
+    kittycat_permission_list_free(admin);
+    kittycat_permission_schema_free(schema);
+
+    return rc;
+}
+
+int permission_view__test()
+{
+    // Parse a row out of a larger buffer so that the last permission is not NUL terminated
+    const char *row = "rpc.test,~rpc.Claim,,apps|trailing";
+    struct KittycatPermissionList *perms = kittycat_permission_list_new_from_buffer(row, 25, ',');
+    struct KittycatPermissionList *expected = perm_list_from_strs((char *[]){"rpc.test", "~rpc.Claim", "global.apps"}, 3);
+
+    int rc = 0;
+    if (!kittycat_permission_lists_equal(perms, expected))
+    {
+        printf("Borrowed permission list does not match\n");
+        rc = 1;
+    }
+
+    for (size_t i = 0; i < perms->len; i++)
+    {
+        if (perms->perms[i]->ownership != KITTYCAT_PERMISSION_OWNERSHIP_INTERNED || perms->perms[i]->perm != kittycat_string_atom_str(perms->perms[i]->perm_atom))
+        {
+            printf("Expected interned strings\n");
+            rc = 1;
+        }
+    }
+
+    // The perm of the last permission is not NUL terminated in the row, but the interned copy is
+    struct kittycat_string *last = kittycat_permission_to_str(perms->perms[2]);
+    if (strcmp(perms->perms[2]->perm->str, "apps") != 0 || strcmp(last->str, "global.apps") != 0 || last->len != 11)
+    {
+        printf("Unexpected last permission %s\n", last->str);
+        rc = 1;
+    }
+    kittycat_string_free(last);
+
+    // Once its strings are interned, parsing a row only allocates the list and the KittycatPermissions
+    size_t before = allocations;
+    struct KittycatPermissionList *again = kittycat_permission_list_new_from_buffer(row, 25, ',');
+    if (allocations - before != 2 + 2 * again->len)
+    {
+        fprintf(stderr, "Parsing a known row made %zu allocations\n", allocations - before);
+        rc = 1;
+    }
+    kittycat_permission_list_free(again);
+
+    struct KittycatPermissionView view;
+    if (kittycat_permission_view_parse("", 0, &view) || !kittycat_permission_view_parse("~bot.x", 6, &view) || !view.negator ||
+        !kittycat_string_view_equal(view.namespace, (struct kittycat_string_view){"bot", 3}) || !kittycat_string_view_equal(view.perm, (struct kittycat_string_view){"x", 1}))
+    {
+        printf("Unexpected permission view\n");
+        rc = 1;
+    }
+
+    kittycat_permission_list_free(perms);
+    kittycat_permission_list_free(expected);
+
+    return rc;
+}
+
+bool has_perms_batch_test_impl(struct KittycatPermissionList *perms, char **query_strs, size_t n)
+{
+    struct KittycatPermissionList *query = perm_list_from_strs(query_strs, n);
+    uint64_t out[2] = {0, 0};
+
+    kittycat_has_perms_batch(perms, (const struct KittycatPermission *const *)query->perms, n, out);
+
+    bool ok = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        bool bit = (out[i / 64] >> (i % 64)) & 1;
+        if (bit != kittycat_has_perm(perms, query->perms[i]))
+        {
+            printf("Batch result for %s disagrees with kittycat_has_perm\n", query_strs[i]);
+            ok = false;
+        }
+    }
+
+    kittycat_permission_list_free(query);
+    return ok;
+}
+
+int has_perms_batch__test()
+{
+    char *query[] = {"rpc.BotClaim", "rpc.ViewBotQueue", "rpc.*", "apps.test", "apps.other", "global.view", "bot.view", "bot.delete", "test", "~rpc.test", "rpc.perm7", "rpc.perm9", "bot.perm8"};
+    size_t n = sizeof(query) / sizeof(query[0]);
+
+    struct KittycatPermissionList *perms = perm_list_from_strs((char *[]){"rpc.*", "~rpc.BotClaim", "apps.test", "global.view", "~global.delete", "bot.delete"}, 6);
+    bool ok = has_perms_batch_test_impl(perms, query, n);
+    kittycat_permission_list_free(perms);
+
+    if (!ok)
+    {
+        return 1;
+    }
+
+    // Large enough to not be indexed on the stack
+    perms = perm_list_from_strs((char *[]){"apps.test", "~global.view"}, 2);
+    for (int i = 0; i < 200; i++)
+    {
+        char buf[32];
+        int len = snprintf(buf, sizeof(buf), "%s.perm%d", i % 2 ? "rpc" : "bot", i);
+        struct kittycat_string *perm_str = kittycat_string_new(buf, len);
+        kittycat_permission_list_add(perms, kittycat_permission_new_from_str(perm_str));
+        kittycat_string_free(perm_str);
+    }
+    kittycat_permission_list_add(perms, kittycat_permission_unpack(kittycat_permission_pack_str("~rpc.perm7", 10)));
+    ok = has_perms_batch_test_impl(perms, query, n);
+    kittycat_permission_list_free(perms);
+
+    return ok ? 0 : 1;
+}
+
+int has_perm_multi__test()
+{
+    struct KittycatPermissionList *users[] = {
+        perm_list_from_strs((char *[]){"rpc.ViewBotQueue"}, 1),
+        perm_list_from_strs((char *[]){"rpc.*", "~rpc.ViewBotQueue"}, 2),
+        perm_list_from_strs((char *[]){"global.*", "~rpc.ViewBotQueue"}, 2),
+        perm_list_from_strs((char *[]){"apps.*"}, 1),
+        perm_list_from_strs((char *[]){"global.ViewBotQueue"}, 1),
+        perm_list_from_strs((char *[]){"rpc.*"}, 1),
+        perm_list_from_strs((char *[]){"rpc.*", "~global.ViewBotQueue"}, 2),
+    };
+    size_t n = sizeof(users) / sizeof(users[0]);
+
+    struct KittycatPermissionSet *sets[sizeof(users) / sizeof(users[0])];
+    for (size_t i = 0; i < n; i++)
+    {
+        sets[i] = kittycat_permission_set_compile(users[i]);
+    }
+
+    struct KittycatPermissionListBatch *batch = kittycat_permission_list_batch_new((const struct KittycatPermissionList *const *)users, n);
+    struct kittycat_string *query_str = kittycat_string_new("rpc.ViewBotQueue", 16);
+    struct KittycatPermission *query = kittycat_permission_new_from_str(query_str);
+
+    uint64_t batch_out = 0;
+    uint64_t sets_out = 0;
+    kittycat_permission_list_batch_has_perm(batch, query, &batch_out);
+    kittycat_permission_sets_has_perm((const struct KittycatPermissionSet *const *)sets, n, query, &sets_out);
+
+    uint64_t expected = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (kittycat_has_perm(users[i], query))
+        {
+            expected |= (uint64_t)1 << i;
+        }
+    }
+
+    int rc = 0;
+    if (expected != 0x35 || batch_out != expected || sets_out != expected)
+    {
+        printf("Expected %llx, got batch=%llx sets=%llx\n", (unsigned long long)expected, (unsigned long long)batch_out, (unsigned long long)sets_out);
+        rc = 1;
+    }
+
+    kittycat_permission_free(query);
+    kittycat_string_free(query_str);
+    kittycat_permission_list_batch_free(batch);
+    for (size_t i = 0; i < n; i++)
+    {
+        kittycat_permission_set_free(sets[i]);
+        kittycat_permission_list_free(users[i]);
+    }
+
+    return rc;
+}
+
+// Arena shared by every sp_resolve_test_impl call, reset after each resolution. Its tiny chunks make resolution span many chunks
+struct kittycat_arena *resolve_arena = NULL;
+
+bool sp_resolve_test_impl(struct StaffKittycatPermissions *sp, struct KittycatPermissionList *expected_perms)
+{
+    struct KittycatPermissionList *perms = kittycat_staff_permissions_resolve(sp);
+
+    // Resolving in an arena must give the same result
+    struct KittycatPermissionList *arena_perms = kittycat_staff_permissions_resolve_in_arena(sp, resolve_arena);
+    if (!kittycat_permission_lists_equal(perms, arena_perms))
+    {
+        fprintf(stderr, "kittycat_staff_permissions_resolve_in_arena disagrees with kittycat_staff_permissions_resolve\n");
+        exit(1);
+    }
+    kittycat_permission_list_free(arena_perms); // No-op, the list is released by the reset below
+    kittycat_arena_reset(resolve_arena);
+
+    // So must the reverse resolve engine
+    struct KittycatPermissionList *reverse_perms = kittycat_staff_permissions_resolve_with_flags(sp, KITTYCAT_RESOLVE_FLAGS_REVERSE);
+    if (!kittycat_permission_lists_equal(perms, reverse_perms))
+    {
+        fprintf(stderr, "KITTYCAT_RESOLVE_FLAGS_REVERSE disagrees with kittycat_staff_permissions_resolve\n");
+        exit(1);
+    }
+    kittycat_permission_list_free(reverse_perms);
+
+    struct kittycat_string *expected_perms_str = kittycat_permission_list_join(expected_perms, ", ");
+    struct kittycat_string *perms_str = kittycat_permission_list_join(perms, ", ");
+    bool res = kittycat_permission_lists_equal(perms, expected_perms);
+
+    printf("Expected: [%s], got [%s], isEqual=%s\n", expected_perms_str->str, perms_str->str, res ? "true" : "false");
+
+    kittycat_permission_list_free(perms);
+    kittycat_permission_list_free(expected_perms);
+    kittycat_string_free(expected_perms_str);
+    kittycat_string_free(perms_str);
+    kittycat_staff_permissions_free(sp);
+
+    return res;
+}
+
+int arena__test()
+{
+    struct kittycat_arena *arena = kittycat_arena_new(256);
+
+    struct kittycat_string *s = kittycat_string_clone_from_chararr_in_arena(arena, "rpc.test", 8);
+    if (strcmp(s->str, "rpc.test") != 0)
+    {
+        return 1;
+    }
+    kittycat_string_free(s); // No-op
+
+    struct KittycatPermissionList *pl = kittycat_permission_list_new_in_arena(arena);
+    for (int i = 0; i < 100; i++)
+    {
+        kittycat_permission_list_add(pl, kittycat_permission_new_from_str_in_arena(arena, s));
+    }
+    kittycat_permission_list_rm(pl, 0);
+
+    if (pl->len != 99 || pl->perms[98]->perm_atom != kittycat_string_atom_lookup("test", 4) || !kittycat_has_perm_cstr(pl, "rpc.test", 8))
+    {
+        return 1;
+    }
+    kittycat_permission_list_free(pl); // Does not free anything
+
+    // Arena allocations are aligned and keep their contents when grown
+    char *a = kittycat_arena_alloc(arena, 3);
+    memcpy(a, "abc", 3);
+    char *b = kittycat_arena_alloc(arena, 1);
+    a = kittycat_arena_realloc(arena, a, 4096);
+    if (((uintptr_t)a % 16) != 0 || ((uintptr_t)b % 16) != 0 || memcmp(a, "abc", 3) != 0)
+    {
+        return 1;
+    }
+
+    // Once reset, an arena that fits in its first chunk does not allocate again
+    kittycat_arena_reset(arena);
+    struct kittycat_string rpcTest = {"rpc.test", 8, false, NULL};
+    size_t before = allocations;
+    for (int i = 0; i < 4; i++)
+    {
+        kittycat_permission_new_from_str_in_arena(arena, &rpcTest);
+    }
+    if (allocations != before || arena->used == 0)
+    {
+        fprintf(stderr, "arena allocated after reset\n");
+        return 1;
+    }
+
+    kittycat_arena_free(arena);
+    return 0;
+}
+
+// Checks the order positions are applied in on a staff member with many positions
+int sp_resolve_order__test()
+{
+    // Position i has index (i % 5) - 1 and perm rpc.p<i>, so the order the perms are resolved in is the order the positions were applied in
+    struct StaffKittycatPermissions *sp = kittycat_staff_permissions_new();
+    char bufs[40][16];
+    char *strs[41];
+    for (int i = 0; i < 40; i++)
+    {
+        snprintf(bufs[i], 16, "rpc.p%d", i);
+        char *perm = bufs[i];
+        kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("pos", (i % 5) - 1, perm_list_from_strs(&perm, 1)));
+    }
+    kittycat_permission_list_add(sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){"rpc.override", 12, false, NULL}));
+
+    size_t n = 0;
+    for (int index = 3; index >= -1; index--)
+    {
+        for (int i = 0; i < 40; i++)
+        {
+            if ((i % 5) - 1 == index)
+            {
+                strs[n++] = bufs[i];
+            }
+        }
+        if (index == 0)
+        {
+            strs[n++] = "rpc.override";
+        }
+    }
+
+    struct KittycatPermissionList *expected = perm_list_from_strs(strs, n);
+    struct KittycatPermissionList *perms = kittycat_staff_permissions_resolve(sp);
+    if (!kittycat_permission_lists_equal(perms, expected))
+    {
+        fprintf(stderr, "positions were not applied in stable descending index order\n");
+        return 1;
+    }
+    kittycat_permission_list_free(perms);
+
+    // Once sorted, resolving with KITTYCAT_RESOLVE_FLAGS_PRESORTED must give the same result
+    struct StaffKittycatPermissions *sorted_sp = kittycat_staff_permissions_new();
+    for (int index = 3; index >= -1; index--)
+    {
+        for (int i = 0; i < 40; i++)
+        {
+            if ((i % 5) - 1 == index)
+            {
+                char *perm = bufs[i];
+                kittycat_partial_staff_position_list_add(sorted_sp->user_positions, kittycat_partial_staff_position_new("pos", index, perm_list_from_strs(&perm, 1)));
+            }
+        }
+    }
+    kittycat_permission_list_add(sorted_sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){"rpc.override", 12, false, NULL}));
+
+    perms = kittycat_staff_permissions_resolve_with_flags(sorted_sp, KITTYCAT_RESOLVE_FLAGS_PRESORTED);
+    if (!kittycat_permission_lists_equal(perms, expected))
+    {
+        fprintf(stderr, "KITTYCAT_RESOLVE_FLAGS_PRESORTED changed the resolved permissions\n");
+        return 1;
+    }
+
+    kittycat_permission_list_free(perms);
+    kittycat_permission_list_free(expected);
+    kittycat_staff_permissions_free(sp);
+    kittycat_staff_permissions_free(sorted_sp);
+    return 0;
+}
+
+// Fills `out` with `n` random permissions from a small vocabulary (so that they often collide), returning the new state of the generator
+//
+// The generator is always stepped, even for n == 0, so that callers deriving the next n from it cannot get stuck
+uint64_t random_test_perms(uint64_t rng, char out[][32], size_t n)
+{
+    rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+    char *vocab[] = {"rpc.a", "rpc.b", "rpc.*", "rpc.@clear", "bot.a", "bot.*", "bot.@clear", "global.a", "global.*", "global.@clear"};
+    size_t vocab_len = sizeof(vocab) / sizeof(vocab[0]);
+
+    for (size_t j = 0; j < n; j++)
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        // @clear is comparatively rare in real positions
+        char *str = vocab[(rng >> 33) % vocab_len];
+        if (strstr(str, "@clear") != NULL && (rng >> 20) % 4 != 0)
+        {
+            str = vocab[4];
+        }
+        snprintf(out[j], 32, "%s%s", (rng >> 50) % 2 ? "~" : "", str);
+    }
+
+    return rng;
+}
+
+// Creates a staff member with `positions` random positions of up to 6 random_test_perms each (at least 1 unless `allow_empty`), with
+// indexes in [index_base, index_base + index_mod)
+struct StaffKittycatPermissions *random_staff_member(uint64_t *rng, size_t positions, bool allow_empty, int32_t index_mod, int32_t index_base)
+{
+    struct StaffKittycatPermissions *sp = kittycat_staff_permissions_new();
+    char perms[6][32];
+    for (size_t p = 0; p < positions; p++)
+    {
+        size_t len = (allow_empty ? 0 : 1) + (*rng >> 40) % 6;
+        *rng = random_test_perms(*rng, perms, len);
+        struct KittycatPermissionList *pl = perm_list_from_strs((char *[]){perms[0], perms[1], perms[2], perms[3], perms[4], perms[5]}, len);
+        kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("pos", (int32_t)((*rng >> 45) % (uint64_t)index_mod) + index_base, pl));
+    }
+    return sp;
+}
+
+// Compares the reverse resolve engine against the default one on randomly generated staff members
+int sp_resolve_reverse__test()
+{
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+
+    char perms[6][32];
+    for (int iter = 0; iter < 2000; iter++)
+    {
+        struct StaffKittycatPermissions *sp = random_staff_member(&rng, (size_t)(1 + (rng >> 60) % 6), true, 4, 0);
+        size_t overrides = (rng >> 30) % 5;
+        rng = random_test_perms(rng, perms, overrides);
+        for (size_t o = 0; o < overrides; o++)
+        {
+            kittycat_permission_list_add(sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){perms[o], strlen(perms[o]), false, NULL}));
+        }
+
+        struct KittycatPermissionList *forward = kittycat_staff_permissions_resolve(sp);
+        struct KittycatPermissionList *reverse = kittycat_staff_permissions_resolve_with_flags(sp, KITTYCAT_RESOLVE_FLAGS_REVERSE);
+        if (!kittycat_permission_lists_equal(forward, reverse))
+        {
+            struct kittycat_string *forward_str = kittycat_permission_list_join(forward, ", ");
+            struct kittycat_string *reverse_str = kittycat_permission_list_join(reverse, ", ");
+            fprintf(stderr, "reverse resolve mismatch on iteration %d: [%s] vs [%s]\n", iter, forward_str->str, reverse_str->str);
+            return 1;
+        }
+
+        kittycat_permission_list_free(forward);
+        kittycat_permission_list_free(reverse);
+        kittycat_staff_permissions_free(sp);
+    }
+
+    return 0;
+}
+
+int position_registry__test()
+{
+    struct kittycat_position_registry *registry = kittycat_position_registry_new();
+
+    size_t head = kittycat_position_registry_add(registry, "head", 4, 1, (const char *const[]){"rpc.*", "~bot.test", "bot.@clear"}, NULL, 3);
+    size_t mod = kittycat_position_registry_add(registry, "mod", 3, 2, (const char *const[]){"~rpc.test", "bot.test", "", "~rpc.test2"}, (const size_t[]){9, 8, 0, 10}, 4);
+
+    if (head == KITTYCAT_POSITION_HANDLE_INVALID || mod == KITTYCAT_POSITION_HANDLE_INVALID || registry->len != 2)
+    {
+        return 1;
+    }
+
+    if (kittycat_position_registry_add(registry, "mod", 3, 5, NULL, NULL, 0) != KITTYCAT_POSITION_HANDLE_INVALID ||
+        kittycat_position_registry_find(registry, "mod", 3) != mod ||
+        kittycat_position_registry_find(registry, "missing", 7) != KITTYCAT_POSITION_HANDLE_INVALID ||
+        kittycat_position_registry_get(registry, mod)->perms->len != 3 ||
+        kittycat_position_registry_get(registry, 2) != NULL)
+    {
+        fprintf(stderr, "kittycat_position_registry lookups are broken\n");
+        return 1;
+    }
+
+    // Many staff members share the same registered positions
+    for (int i = 0; i < 4; i++)
+    {
+        struct StaffKittycatPermissions *sp = kittycat_staff_permissions_new();
+        if (!kittycat_staff_permissions_add_position(sp, registry, head) || !kittycat_staff_permissions_add_position(sp, registry, mod))
+        {
+            return 1;
+        }
+        if (kittycat_staff_permissions_add_position(sp, registry, 2))
+        {
+            return 1;
+        }
+        kittycat_permission_list_add(sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){"~rpc.test3", 10, false, NULL}));
+
+        struct KittycatPermissionList *expected = perm_list_from_strs((char *[]){"rpc.*", "~rpc.test3"}, 2);
+        if (!sp_resolve_test_impl(sp, expected))
+        {
+            return 1;
+        }
+    }
+
+    kittycat_position_registry_free(registry);
+    return 0;
+}
+
+// Creates a staff member holding positions `a` (index 1) and `b` (index 2) in the given order, with an optional perm override
+struct StaffKittycatPermissions *resolve_cache_test_sp(bool a_first, char *override)
+{
+    struct StaffKittycatPermissions *sp = kittycat_staff_permissions_new();
+    struct KittycatPartialStaffPosition *a = kittycat_partial_staff_position_new("a", 1, perm_list_from_strs((char *[]){"rpc.test", "~bot.test"}, 2));
+    struct KittycatPartialStaffPosition *b = kittycat_partial_staff_position_new("b", 2, perm_list_from_strs((char *[]){"bot.*"}, 1));
+    kittycat_partial_staff_position_list_add(sp->user_positions, a_first ? a : b);
+    kittycat_partial_staff_position_list_add(sp->user_positions, a_first ? b : a);
+    if (override != NULL)
+    {
+        kittycat_permission_list_add(sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){override, strlen(override), false, NULL}));
+    }
+    return sp;
+}
+
+int resolve_cache__test()
+{
+    struct kittycat_resolve_cache *cache = kittycat_resolve_cache_new(2);
+
+    struct StaffKittycatPermissions *sp1 = resolve_cache_test_sp(true, NULL);
+    struct StaffKittycatPermissions *sp2 = resolve_cache_test_sp(false, NULL);
+    struct StaffKittycatPermissions *sp3 = resolve_cache_test_sp(true, "~rpc.test");
+
+    struct KittycatResolvedPermissions *r1 = kittycat_resolve_cache_get(cache, sp1);
+    struct KittycatPermissionList *expected = kittycat_staff_permissions_resolve(sp1);
+    if (!kittycat_permission_lists_equal(r1->perms, expected))
+    {
+        return 1;
+    }
+    kittycat_permission_list_free(expected);
+
+    // The same positions in another order hit the cache without allocating
+    size_t before = allocations;
+    struct KittycatResolvedPermissions *r2 = kittycat_resolve_cache_get(cache, sp2);
+    if (r2 != r1 || allocations != before || cache->hits != 1 || cache->misses != 1)
+    {
+        fprintf(stderr, "kittycat_resolve_cache_get missed or allocated on a hit\n");
+        return 1;
+    }
+    kittycat_resolved_permissions_release(r2);
+
+    // Perm overrides are part of the key
+    struct KittycatResolvedPermissions *r3 = kittycat_resolve_cache_get(cache, sp3);
+    if (r3 == r1 || kittycat_has_perm_cstr(r3->perms, "rpc.test", 8) || cache->misses != 2 || cache->len != 2)
+    {
+        return 1;
+    }
+
+    // Invalidating a position drops every entry including it. r1 and r3 stay valid as we still hold references to them
+    if (kittycat_resolve_cache_invalidate_position(cache, "a", 1) != 2 || cache->len != 0 || !kittycat_has_perm_cstr(r1->perms, "rpc.test", 8))
+    {
+        return 1;
+    }
+
+    // A full cache evicts its least recently used entry
+    kittycat_resolved_permissions_release(kittycat_resolve_cache_get(cache, sp1));
+    kittycat_resolved_permissions_release(kittycat_resolve_cache_get(cache, sp3));
+    kittycat_resolved_permissions_release(kittycat_resolve_cache_get(cache, sp1));
+    struct StaffKittycatPermissions *sp4 = resolve_cache_test_sp(true, "bot.extra");
+    kittycat_resolved_permissions_release(kittycat_resolve_cache_get(cache, sp4));
+    uint64_t misses = cache->misses;
+    kittycat_resolved_permissions_release(kittycat_resolve_cache_get(cache, sp1));
+    kittycat_resolved_permissions_release(kittycat_resolve_cache_get(cache, sp3));
+    if (cache->len != 2 || cache->misses != misses + 1)
+    {
+        fprintf(stderr, "kittycat_resolve_cache did not evict the least recently used entry\n");
+        return 1;
+    }
+
+    // The index of a position is part of the key, as it decides whether the position is applied before or after the perm overrides
+    kittycat_resolve_cache_clear(cache);
+    struct StaffKittycatPermissions *above = kittycat_staff_permissions_new();
+    struct StaffKittycatPermissions *below = kittycat_staff_permissions_new();
+    kittycat_partial_staff_position_list_add(above->user_positions, kittycat_partial_staff_position_new("a", 1, perm_list_from_strs((char *[]){"~rpc.test"}, 1)));
+    kittycat_partial_staff_position_list_add(below->user_positions, kittycat_partial_staff_position_new("a", -1, perm_list_from_strs((char *[]){"~rpc.test"}, 1)));
+    kittycat_permission_list_add(above->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){"rpc.test", 8, false, NULL}));
+    kittycat_permission_list_add(below->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){"rpc.test", 8, false, NULL}));
+    struct KittycatResolvedPermissions *r_above = kittycat_resolve_cache_get(cache, above);
+    struct KittycatResolvedPermissions *r_below = kittycat_resolve_cache_get(cache, below);
+    if (r_above == r_below || !kittycat_has_perm_cstr(r_above->perms, "rpc.test", 8) || kittycat_has_perm_cstr(r_below->perms, "rpc.test", 8) ||
+        kittycat_resolve_cache_invalidate_position(cache, "a", 1) != 2)
+    {
+        fprintf(stderr, "kittycat_resolve_cache mixed up positions with the same id but different indexes\n");
+        return 1;
+    }
+    kittycat_resolved_permissions_release(r_above);
+    kittycat_resolved_permissions_release(r_below);
+    kittycat_staff_permissions_free(above);
+    kittycat_staff_permissions_free(below);
+
+    kittycat_resolve_cache_free(cache);
+    kittycat_resolved_permissions_release(r1);
+    kittycat_resolved_permissions_release(r3);
+    kittycat_staff_permissions_free(sp1);
+    kittycat_staff_permissions_free(sp2);
+    kittycat_staff_permissions_free(sp3);
+    kittycat_staff_permissions_free(sp4);
+    return 0;
+}
+
+int resolve_tracker__test()
+{
+    struct kittycat_position_registry *registry = kittycat_position_registry_new();
+    struct kittycat_resolve_tracker *tracker = kittycat_resolve_tracker_new(registry);
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+    char perms[6][32];
+    const char *perm_ptrs[6];
+    for (size_t j = 0; j < 6; j++)
+    {
+        perm_ptrs[j] = perms[j];
+    }
+
+    size_t n_positions = 6;
+    for (size_t i = 0; i < n_positions; i++)
+    {
+        char id[8];
+        snprintf(id, sizeof(id), "p%zu", i);
+        size_t n = (rng >> 40) % 6;
+        rng = random_test_perms(rng, perms, n);
+        kittycat_position_registry_add(registry, id, strlen(id), (int32_t)((rng >> 45) % 4), perm_ptrs, NULL, n);
+    }
+
+    size_t n_users = 32;
+    struct StaffKittycatPermissions *users[32];
+    struct KittycatPermissionList *previous[32];
+    for (size_t u = 0; u < n_users; u++)
+    {
+        users[u] = kittycat_staff_permissions_new();
+        for (size_t i = 0; i < n_positions; i++)
+        {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            if ((rng >> 40) % 3 == 0)
+            {
+                kittycat_staff_permissions_add_position(users[u], registry, i);
+            }
+        }
+        if (u % 4 == 0)
+        {
+            rng = random_test_perms(rng, perms, 1);
+            kittycat_permission_list_add(users[u]->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){perms[0], strlen(perms[0]), false, NULL}));
+        }
+
+        if (kittycat_resolve_tracker_add_user(tracker, users[u]) != u)
+        {
+            return 1;
+        }
+        previous[u] = kittycat_staff_permissions_resolve(users[u]);
+    }
+
+    for (int iter = 0; iter < 500; iter++)
+    {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t handle = (rng >> 40) % n_positions;
+        const struct KittycatPartialStaffPosition *pos = kittycat_position_registry_get(registry, handle);
+        // Mostly edit the permissions of a position, which is what the tracker is built for
+        int32_t index = (rng >> 20) % 8 == 0 ? (int32_t)((rng >> 45) % 4) : pos->index;
+        size_t n = (rng >> 30) % 6;
+        rng = random_test_perms(rng, perms, n);
+
+        size_t changed[32];
+        size_t n_changed = kittycat_resolve_tracker_update_position(tracker, handle, index, perm_ptrs, NULL, n, changed);
+
+        // Every user must match a full resolve, and exactly those whose permissions differ must be reported
+        size_t expected_changed = 0;
+        for (size_t u = 0; u < n_users; u++)
+        {
+            struct KittycatPermissionList *expected = kittycat_staff_permissions_resolve(users[u]);
+            if (!kittycat_permission_lists_equal(expected, kittycat_resolve_tracker_get(tracker, u)))
+            {
+                struct kittycat_string *expected_str = kittycat_permission_list_join(expected, ", ");
+                struct kittycat_string *got_str = kittycat_permission_list_join(kittycat_resolve_tracker_get(tracker, u), ", ");
+                fprintf(stderr, "resolve tracker mismatch on iteration %d for user %zu: [%s] vs [%s]\n", iter, u, expected_str->str, got_str->str);
+                return 1;
+            }
+
+            if (!kittycat_permission_lists_equal(expected, previous[u]))
+            {
+                if (expected_changed >= n_changed || changed[expected_changed] != u)
+                {
+                    fprintf(stderr, "resolve tracker did not report user %zu as changed on iteration %d\n", u, iter);
+                    return 1;
+                }
+                expected_changed++;
+            }
+
+            kittycat_permission_list_free(previous[u]);
+            previous[u] = expected;
+        }
+
+        if (n_changed != expected_changed)
+        {
+            fprintf(stderr, "resolve tracker reported %zu changed users instead of %zu on iteration %d\n", n_changed, expected_changed, iter);
+            return 1;
+        }
+    }
+
+    if (tracker->partial_resolves == 0 || tracker->full_resolves == 0 ||
+        kittycat_resolve_tracker_update_position(tracker, n_positions, 0, NULL, NULL, 0, NULL) != KITTYCAT_RESOLVE_TRACKER_USER_INVALID ||
+        kittycat_resolve_tracker_get(tracker, n_users) != NULL)
+    {
+        return 1;
+    }
+
+    for (size_t u = 0; u < n_users; u++)
+    {
+        kittycat_permission_list_free(previous[u]);
+    }
+    kittycat_resolve_tracker_free(tracker);
+    kittycat_position_registry_free(registry);
+    return 0;
+}
+
+int resolve_batch__test()
+{
+    size_t n = 700;
+    struct StaffKittycatPermissions **sp = malloc(n * sizeof(struct StaffKittycatPermissions *));
+    struct KittycatPermissionList **out = malloc(n * sizeof(struct KittycatPermissionList *));
+    uint64_t rng = 0xD1B54A32D192ED03ULL;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        sp[i] = random_staff_member(&rng, 1 + i % 4, false, 4, 0);
+    }
+
+    struct KittycatResolveBatchOptions opts[] = {{4, KITTYCAT_RESOLVE_FLAGS_NONE}, {3, KITTYCAT_RESOLVE_FLAGS_REVERSE}, {1, KITTYCAT_RESOLVE_FLAGS_NONE}};
+    for (size_t o = 0; o <= sizeof(opts) / sizeof(opts[0]); o++)
+    {
+        // The last round runs with the default options
+        struct KittycatResolveBatchOptions *opt = o < sizeof(opts) / sizeof(opts[0]) ? &opts[o] : NULL;
+        size_t used = kittycat_staff_permissions_resolve_batch((const struct StaffKittycatPermissions *const *)sp, n, out, opt);
+        if (used == 0 || (opt != NULL && used > opt->threads))
+        {
+            fprintf(stderr, "kittycat_staff_permissions_resolve_batch used %zu threads\n", used);
+            return 1;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            struct KittycatPermissionList *expected = kittycat_staff_permissions_resolve(sp[i]);
+            if (!kittycat_permission_lists_equal(expected, out[i]))
+            {
+                fprintf(stderr, "kittycat_staff_permissions_resolve_batch disagrees with kittycat_staff_permissions_resolve for %zu\n", i);
+                return 1;
+            }
+            kittycat_permission_list_free(expected);
+            kittycat_permission_list_free(out[i]);
+        }
+    }
+
+    // Small batches are not worth a thread
+    struct KittycatResolveBatchOptions many = {8, KITTYCAT_RESOLVE_FLAGS_NONE};
+    if (kittycat_staff_permissions_resolve_batch((const struct StaffKittycatPermissions *const *)sp, 3, out, &many) != 1 ||
+        kittycat_staff_permissions_resolve_batch((const struct StaffKittycatPermissions *const *)sp, 0, out, &many) != 1)
+    {
+        return 1;
+    }
+    for (size_t i = 0; i < 3; i++)
+    {
+        kittycat_permission_list_free(out[i]);
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        kittycat_staff_permissions_free(sp[i]);
+    }
+    free(sp);
+    free(out);
+    return 0;
+}
+
+int resolver__test()
+{
+    struct kittycat_resolver *resolver = kittycat_resolver_new();
+    struct kittycat_arena *arena = kittycat_arena_new(1 << 16);
+    uint64_t rng = 0x94D049BB133111EBULL;
+
+    size_t n = 64;
+    struct StaffKittycatPermissions *sp[64];
+    for (size_t i = 0; i < n; i++)
+    {
+        sp[i] = random_staff_member(&rng, 1 + i % 5, false, 4, 0);
+    }
+
+    // One staff member big enough for the scratch kittycat_hashmaps to grow
+    struct KittycatPermissionList *big = kittycat_permission_list_new();
+    for (int i = 0; i < 200; i++)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%sbot.p%d", i % 7 == 0 ? "~" : "", i);
+        kittycat_permission_list_add(big, kittycat_permission_new_from_str(&(struct kittycat_string){buf, strlen(buf), false, NULL}));
+    }
+    kittycat_partial_staff_position_list_add(sp[n / 2]->user_positions, kittycat_partial_staff_position_new("big", 2, big));
+
+    // The first round warms up the resolver (and the arena), checking it against kittycat_staff_permissions_resolve
+    for (size_t i = 0; i < n; i++)
+    {
+        struct KittycatPermissionList *expected = kittycat_staff_permissions_resolve(sp[i]);
+        struct KittycatPermissionList *got = kittycat_resolver_resolve(resolver, sp[i], NULL);
+        struct KittycatPermissionList *got_arena = kittycat_resolver_resolve(resolver, sp[i], arena);
+        if (!kittycat_permission_lists_equal(expected, got) || !kittycat_permission_lists_equal(expected, got_arena))
+        {
+            fprintf(stderr, "kittycat_resolver_resolve disagrees with kittycat_staff_permissions_resolve for %zu\n", i);
+            return 1;
+        }
+        kittycat_permission_list_free(expected);
+        kittycat_permission_list_free(got);
+        kittycat_arena_reset(arena);
+    }
+
+    // After warm-up, resolving into an arena does not allocate at all
+    size_t before = allocations;
+    for (int round = 0; round < 3; round++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            kittycat_resolver_resolve(resolver, sp[i], arena);
+            kittycat_arena_reset(arena);
+        }
+    }
+    if (allocations != before)
+    {
+        fprintf(stderr, "kittycat_resolver_resolve made %zu allocations after warm-up\n", allocations - before);
+        return 1;
+    }
+
+    // Without an arena, only the output is allocated: the list, its array and one KittycatPermission per entry
+    for (size_t i = 0; i < n; i++)
+    {
+        before = allocations;
+        struct KittycatPermissionList *got = kittycat_resolver_resolve(resolver, sp[i], NULL);
+        if (allocations - before != 3 + got->len)
+        {
+            fprintf(stderr, "kittycat_resolver_resolve made %zu allocations for an output of %zu\n", allocations - before, got->len);
+            return 1;
+        }
+        kittycat_permission_list_free(got);
+    }
+
+    if (resolver->resolves != 6 * n)
+    {
+        return 1;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        kittycat_staff_permissions_free(sp[i]);
+    }
+    kittycat_arena_free(arena);
+    kittycat_resolver_free(resolver);
+    return 0;
+}
+
+int resolve_to_set__test()
+{
+    struct kittycat_resolver *resolver = kittycat_resolver_new();
+    uint64_t rng = 0xBF58476D1CE4E5B9ULL;
+    char *queries[] = {"rpc.a", "rpc.b", "rpc.c", "bot.a", "bot.b", "global.a", "global.b", "apps.a", "~rpc.a", "~bot.a"};
+    size_t n_queries = sizeof(queries) / sizeof(queries[0]);
+
+    for (int iter = 0; iter < 300; iter++)
+    {
+        struct StaffKittycatPermissions *sp = random_staff_member(&rng, (size_t)(1 + iter % 4), false, 4, 0);
+
+        struct KittycatPermissionList *resolved = kittycat_staff_permissions_resolve(sp);
+        struct KittycatPermissionSet *compiled = kittycat_permission_set_compile(resolved);
+        struct KittycatPermissionSet *fused = kittycat_staff_permissions_resolve_to_set(sp);
+
+        // Once the resolver has seen the staff member, only the KittycatPermissionSet itself (struct and two tables) is allocated
+        kittycat_permission_set_free(kittycat_resolver_resolve_to_set(resolver, sp));
+        size_t before = allocations;
+        struct KittycatPermissionSet *reused = kittycat_resolver_resolve_to_set(resolver, sp);
+        if (allocations - before != 3)
+        {
+            fprintf(stderr, "kittycat_resolver_resolve_to_set made %zu allocations\n", allocations - before);
+            return 1;
+        }
+
+        if (fused->len != compiled->len || reused->len != compiled->len || fused->global_star != compiled->global_star)
+        {
+            fprintf(stderr, "kittycat_staff_permissions_resolve_to_set disagrees with compiling the resolved list on iteration %d\n", iter);
+            return 1;
+        }
+
+        for (size_t q = 0; q < n_queries; q++)
+        {
+            struct KittycatPermission *query = kittycat_permission_new_from_str(&(struct kittycat_string){queries[q], strlen(queries[q]), false, NULL});
+            bool expected = kittycat_has_perm(resolved, query);
+            if (kittycat_permission_set_has(fused, query) != expected || kittycat_permission_set_has(reused, query) != expected)
+            {
+                fprintf(stderr, "kittycat_staff_permissions_resolve_to_set gives the wrong answer for %s on iteration %d\n", queries[q], iter);
+                return 1;
+            }
+            kittycat_permission_free(query);
+        }
+
+        kittycat_permission_set_free(compiled);
+        kittycat_permission_set_free(fused);
+        kittycat_permission_set_free(reused);
+        kittycat_permission_list_free(resolved);
+        kittycat_staff_permissions_free(sp);
+    }
+
+    kittycat_resolver_free(resolver);
+    return 0;
+}
+
+int staff_has_perm__test()
+{
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    char *queries[] = {"rpc.a", "rpc.b", "rpc.c", "rpc.*", "bot.a", "bot.*", "global.a", "global.*", "apps.a", "b"};
+    size_t n_queries = sizeof(queries) / sizeof(queries[0]);
+
+    struct KittycatPermission *query[10];
+    for (size_t q = 0; q < n_queries; q++)
+    {
+        query[q] = kittycat_permission_new_from_str(&(struct kittycat_string){queries[q], strlen(queries[q]), false, NULL});
+    }
+
+    char perms[6][32];
+    for (int iter = 0; iter < 2000; iter++)
+    {
+        // Negative indexes are applied after the perm overrides
+        struct StaffKittycatPermissions *sp = random_staff_member(&rng, (size_t)(iter % 6), true, 5, -1);
+        size_t overrides = (rng >> 30) % 3;
+        rng = random_test_perms(rng, perms, overrides);
+        for (size_t o = 0; o < overrides; o++)
+        {
+            kittycat_permission_list_add(sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){perms[o], strlen(perms[o]), false, NULL}));
+        }
+
+        struct KittycatPermissionList *resolved = kittycat_staff_permissions_resolve(sp);
+        for (size_t q = 0; q < n_queries; q++)
+        {
+            size_t before = allocations;
+            bool got = kittycat_staff_has_perm(sp, query[q]);
+            if (allocations != before)
+            {
+                fprintf(stderr, "kittycat_staff_has_perm allocated\n");
+                return 1;
+            }
+
+            if (got != kittycat_has_perm(resolved, query[q]))
+            {
+                struct kittycat_string *resolved_str = kittycat_permission_list_join(resolved, ", ");
+                fprintf(stderr, "kittycat_staff_has_perm(%s) disagrees with [%s] on iteration %d\n", queries[q], resolved_str->str, iter);
+                return 1;
+            }
+        }
+
+        kittycat_permission_list_free(resolved);
+        kittycat_staff_permissions_free(sp);
+    }
+
+    for (size_t q = 0; q < n_queries; q++)
     {
-        printf("Expected true, got false\n");
-        return 1;
+        kittycat_permission_free(query[q]);
     }
 
-    return 0;
-}
-
-bool sp_resolve_test_impl(struct StaffKittycatPermissions *sp, struct KittycatPermissionList *expected_perms)
-{
-    struct KittycatPermissionList *perms = kittycat_staff_permissions_resolve(sp);
-
-    struct kittycat_string *expected_perms_str = kittycat_permission_list_join(expected_perms, ", ");
-    struct kittycat_string *perms_str = kittycat_permission_list_join(perms, ", ");
-    bool res = kittycat_permission_lists_equal(perms, expected_perms);
+    // Conflicts between positions of the same index (and the perm overrides, which count as index 0) are decided by the order they are
+    // applied in, which random cases rarely exercise
+    struct
+    {
+        int32_t indexes[3];
+        char *perms[3];
+        size_t len;
+        char *overrides;
+        bool expected;
+    } cases[] = {
+        {{0, 1, 0}, {"rpc.a", "bot.b", "~rpc.a"}, 3, NULL, false},
+        {{0, 1, 0}, {"~rpc.a", "bot.b", "rpc.a"}, 3, NULL, true},
+        {{0, 1, 0}, {"~rpc.a", "bot.b", "bot.c"}, 3, "rpc.a", true},
+        {{-1, 1, 0}, {"~rpc.a", "bot.b", "bot.c"}, 3, "rpc.a", false},
+        {{0, 0}, {"rpc.a", "~rpc.a"}, 2, NULL, false},
+        {{0}, {"~rpc.a"}, 1, "rpc.a", true},
+        {{-1}, {"~rpc.a"}, 1, "rpc.a", false},
+        {{0, -1}, {"~rpc.a", "rpc.@clear"}, 2, "rpc.a", false},
+    };
+
+    struct KittycatPermission *rpc_a = kittycat_permission_new_from_str(&(struct kittycat_string){"rpc.a", 5, false, NULL});
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        struct StaffKittycatPermissions *sp = kittycat_staff_permissions_new();
+        for (size_t p = 0; p < cases[c].len; p++)
+        {
+            kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("pos", cases[c].indexes[p], perm_list_from_strs(&cases[c].perms[p], 1)));
+        }
+        if (cases[c].overrides != NULL)
+        {
+            kittycat_permission_list_add(sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){cases[c].overrides, strlen(cases[c].overrides), false, NULL}));
+        }
 
-    printf("Expected: [%s], got [%s], isEqual=%s\n", expected_perms_str->str, perms_str->str, res ? "true" : "false");
+        struct KittycatPermissionList *resolved = kittycat_staff_permissions_resolve(sp);
+        bool got = kittycat_staff_has_perm(sp, rpc_a);
+        if (got != cases[c].expected || got != kittycat_has_perm(resolved, rpc_a))
+        {
+            fprintf(stderr, "kittycat_staff_has_perm(rpc.a) is wrong for ordering case %zu\n", c);
+            return 1;
+        }
 
-    kittycat_permission_list_free(perms);
-    kittycat_permission_list_free(expected_perms);
-    kittycat_string_free(expected_perms_str);
-    kittycat_string_free(perms_str);
-    kittycat_staff_permissions_free(sp);
+        kittycat_permission_list_free(resolved);
+        kittycat_staff_permissions_free(sp);
+    }
+    kittycat_permission_free(rpc_a);
 
-    return res;
+    return 0;
 }
 
 int sp_resolve__test()
@@ -382,6 +1524,72 @@ int sp_resolve__test()
         return 1;
     }
 
+    // Clearing a namespace removes every perm of it, even when they are interleaved with other namespaces
+    expected = perm_list_from_strs((char *[]){"bot.test"}, 1);
+    sp = kittycat_staff_permissions_new();
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test", 2, perm_list_from_strs((char *[]){"rpc.test", "rpc.test2", "bot.test"}, 3)));
+    kittycat_permission_list_add(sp->perm_overrides, kittycat_permission_new_from_str(&(struct kittycat_string){"rpc.@clear", 10, false, NULL}));
+
+    if (!sp_resolve_test_impl(sp, expected))
+    {
+        return 1;
+    }
+
+    // A * perm removes every negator of its namespace
+    expected = perm_list_from_strs((char *[]){"bot.test", "rpc.*"}, 2);
+    sp = kittycat_staff_permissions_new();
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test2", 2, perm_list_from_strs((char *[]){"~rpc.test", "~rpc.test2", "bot.test"}, 3)));
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test", 1, perm_list_from_strs((char *[]){"rpc.*"}, 1)));
+
+    if (!sp_resolve_test_impl(sp, expected))
+    {
+        return 1;
+    }
+
+    // Clears and * perms only touch their own namespace
+    expected = perm_list_from_strs((char *[]){"rpc.a", "rpc.*", "bot.d", "~rpc.e"}, 4);
+    sp = kittycat_staff_permissions_new();
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test3", 3, perm_list_from_strs((char *[]){"rpc.a", "bot.a", "~rpc.b", "bot.b", "~bot.c"}, 5)));
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test2", 2, perm_list_from_strs((char *[]){"bot.@clear", "rpc.*"}, 2)));
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test", 1, perm_list_from_strs((char *[]){"bot.d", "~rpc.e"}, 2)));
+
+    if (!sp_resolve_test_impl(sp, expected))
+    {
+        return 1;
+    }
+
+    // Positions sharing an index are applied in the order they were added
+    expected = perm_list_from_strs((char *[]){"bot.test", "~rpc.test"}, 2);
+    sp = kittycat_staff_permissions_new();
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("x", 1, perm_list_from_strs((char *[]){"rpc.test"}, 1)));
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("y", 1, perm_list_from_strs((char *[]){"~rpc.test"}, 1)));
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("a", 2, perm_list_from_strs((char *[]){"bot.test"}, 1)));
+
+    if (!sp_resolve_test_impl(sp, expected))
+    {
+        return 1;
+    }
+
+    // Overriding many perms one by one keeps the order in which the overrides were applied
+    char *many_perms[40];
+    char many_perms_buf[40][16];
+    for (int i = 0; i < 20; i++)
+    {
+        snprintf(many_perms_buf[i], 16, "rpc.p%d", i);
+        snprintf(many_perms_buf[20 + i], 16, "~rpc.p%d", i);
+        many_perms[i] = many_perms_buf[i];
+        many_perms[20 + i] = many_perms_buf[20 + i];
+    }
+    expected = perm_list_from_strs(many_perms + 20, 20);
+    sp = kittycat_staff_permissions_new();
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test2", 2, perm_list_from_strs(many_perms, 20)));
+    kittycat_partial_staff_position_list_add(sp->user_positions, kittycat_partial_staff_position_new("test", 1, perm_list_from_strs(many_perms + 20, 20)));
+
+    if (!sp_resolve_test_impl(sp, expected))
+    {
+        return 1;
+    }
+
     // Free memory
     kittycat_string_free(rpcTest);
     kittycat_string_free(rpcTest2);
@@ -398,9 +1606,302 @@ int sp_resolve__test()
     return 0;
 }
 
+// Runs kittycat_check_patch_changes on string lists, checking the state and (on failure) the failing KittycatPermissions
+//
+// When several changes fail, which one is reported depends on the order they are checked in. Passing NULL as `failing` for a refused
+// patch only checks that it is refused
+bool check_patch_changes_test_impl(char **manager, size_t manager_len, char **current, size_t current_len, char **new, size_t new_len, enum KittycatPermissionCheckPatchChangesResultState state, char **failing)
+{
+    struct KittycatPermissionList *manager_perms = perm_list_from_strs(manager, manager_len);
+    struct KittycatPermissionList *current_perms = perm_list_from_strs(current, current_len);
+    struct KittycatPermissionList *new_perms = perm_list_from_strs(new, new_len);
+
+    struct KittycatPermissionCheckPatchChangesResult result = kittycat_check_patch_changes(manager_perms, current_perms, new_perms);
+    bool ok = failing == NULL && state != KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK
+                  ? result.state != KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK
+                  : result.state == state;
+    if (ok && failing != NULL)
+    {
+        size_t failing_len = state == KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_NO_PERMISSION ? 1 : 2;
+        struct KittycatPermissionList *expected = perm_list_from_strs(failing, failing_len);
+        ok = kittycat_permission_lists_equal(expected, result.failing_perms);
+        kittycat_permission_list_free(expected);
+    }
+
+    if (result.failing_perms != NULL)
+    {
+        kittycat_permission_list_free(result.failing_perms);
+    }
+    kittycat_permission_list_free(manager_perms);
+    kittycat_permission_list_free(current_perms);
+    kittycat_permission_list_free(new_perms);
+
+    return ok;
+}
+
+int check_patch_changes__test()
+{
+    enum KittycatPermissionCheckPatchChangesResultState ok = KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK;
+    enum KittycatPermissionCheckPatchChangesResultState no_permission = KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_NO_PERMISSION;
+    enum KittycatPermissionCheckPatchChangesResultState lacks_negator = KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD;
+
+    // Same cases as the other kittycat implementations
+    if (!check_patch_changes_test_impl((char *[]){"global.*"}, 1, (char *[]){"rpc.test"}, 1, (char *[]){"rpc.test", "rpc.test2"}, 2, ok, NULL))
+    {
+        fprintf(stderr, "check_patch_changes: global.* should allow adding rpc.test2\n");
+        return 1;
+    }
+
+    if (!check_patch_changes_test_impl((char *[]){"rpc.*"}, 1, (char *[]){"global.*"}, 1, (char *[]){"rpc.test", "rpc.test2"}, 2, no_permission, (char *[]){"global.*"}))
+    {
+        fprintf(stderr, "check_patch_changes: rpc.* should not allow removing global.*\n");
+        return 1;
+    }
+
+    if (!check_patch_changes_test_impl((char *[]){"rpc.*"}, 1, (char *[]){"rpc.test"}, 1, (char *[]){"rpc.test", "rpc.test2"}, 2, ok, NULL))
+    {
+        fprintf(stderr, "check_patch_changes: rpc.* should allow adding rpc.test2\n");
+        return 1;
+    }
+
+    if (!check_patch_changes_test_impl((char *[]){"~rpc.test", "rpc.*"}, 2, (char *[]){"rpc.foobar"}, 1, (char *[]){"rpc.*"}, 1, lacks_negator, (char *[]){"rpc.*", "~rpc.test"}))
+    {
+        fprintf(stderr, "check_patch_changes: rpc.* without ~rpc.test should be refused\n");
+        return 1;
+    }
+
+    if (!check_patch_changes_test_impl((char *[]){"~rpc.test", "rpc.*"}, 2, (char *[]){"~rpc.test"}, 1, (char *[]){"rpc.*"}, 1, lacks_negator, NULL))
+    {
+        fprintf(stderr, "check_patch_changes: dropping ~rpc.test for rpc.* should be refused\n");
+        return 1;
+    }
+
+    if (!check_patch_changes_test_impl((char *[]){"~rpc.test", "rpc.*"}, 2, (char *[]){"~rpc.test"}, 1, (char *[]){"rpc.*", "~rpc.test", "~rpc.test2"}, 3, ok, NULL))
+    {
+        fprintf(stderr, "check_patch_changes: rpc.* keeping ~rpc.test should be allowed\n");
+        return 1;
+    }
+
+    if (!check_patch_changes_test_impl((char *[]){"~rpc.test", "rpc.*"}, 2, (char *[]){"~rpc.test"}, 1, (char *[]){"rpc.*", "~rpc.test2", "~rpc.test2"}, 3, lacks_negator, NULL))
+    {
+        fprintf(stderr, "check_patch_changes: rpc.* without ~rpc.test (but a duplicated ~rpc.test2) should be refused\n");
+        return 1;
+    }
+
+    // Unchanged KittycatPermissions are not checked, even if the manager lacks them
+    if (!check_patch_changes_test_impl((char *[]){"rpc.test"}, 1, (char *[]){"bot.a", "~apps.b", "rpc.c"}, 3, (char *[]){"~apps.b", "rpc.test", "bot.a", "rpc.c", "bot.a"}, 5, ok, NULL))
+    {
+        fprintf(stderr, "check_patch_changes: only rpc.test was added\n");
+        return 1;
+    }
+
+    if (!check_patch_changes_test_impl((char *[]){"rpc.*"}, 1, (char *[]){"~bot.a", "rpc.c"}, 2, (char *[]){"rpc.c"}, 1, no_permission, (char *[]){"~bot.a"}))
+    {
+        fprintf(stderr, "check_patch_changes: rpc.* should not allow removing ~bot.a\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int patch_checker__test()
+{
+    struct KittycatPermissionList *manager_perms = perm_list_from_strs((char *[]){"~rpc.a", "global.*", "~bot.c", "~bot.b", "~rpc.a"}, 5);
+    struct kittycat_patch_checker *checker = kittycat_patch_checker_new(manager_perms);
+
+    struct
+    {
+        char *current[3];
+        size_t current_len;
+        char *new[4];
+        size_t new_len;
+        enum KittycatPermissionCheckPatchChangesResultState state;
+        char *failing[2];
+    } cases[] = {
+        {{"rpc.x"}, 1, {"rpc.*", "~rpc.a"}, 2, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK, {NULL}},
+        {{"rpc.x"}, 1, {"rpc.*"}, 1, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD, {"rpc.*", "~rpc.a"}},
+        {{"~bot.b"}, 1, {"bot.*", "~bot.b"}, 2, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD, {"bot.*", "~bot.c"}},
+        {{"~bot.b"}, 1, {"bot.*", "~bot.c", "~bot.b"}, 3, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK, {NULL}},
+        {{"bot.*", "rpc.x"}, 2, {"rpc.x", "~bot.b"}, 2, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD, {"bot.*", "~bot.c"}},
+        {{"apps.x"}, 1, {"apps.*", "global.y"}, 2, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK, {NULL}},
+        {{"rpc.x"}, 1, {"rpc.x"}, 1, KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK, {NULL}},
+    };
+
+    // The same checker is used for every patch, and must agree with kittycat_check_patch_changes
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        struct KittycatPermissionList *current_perms = perm_list_from_strs(cases[c].current, cases[c].current_len);
+        struct KittycatPermissionList *new_perms = perm_list_from_strs(cases[c].new, cases[c].new_len);
+
+        size_t before = allocations;
+        struct KittycatPermissionCheckPatchChangesResult result = kittycat_patch_checker_check(checker, current_perms, new_perms);
+        if (result.state == KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK && allocations != before + 1)
+        {
+            fprintf(stderr, "kittycat_patch_checker_check made %zu allocations for case %zu instead of 1\n", allocations - before, c);
+            return 1;
+        }
+
+        struct KittycatPermissionCheckPatchChangesResult expected = kittycat_check_patch_changes(manager_perms, current_perms, new_perms);
+        if (result.state != cases[c].state || expected.state != cases[c].state)
+        {
+            fprintf(stderr, "kittycat_patch_checker_check returned state %d for case %zu instead of %d\n", result.state, c, cases[c].state);
+            return 1;
+        }
+
+        if (result.state != KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK)
+        {
+            struct KittycatPermissionList *failing = perm_list_from_strs(cases[c].failing, result.failing_perms->len);
+            if (result.failing_perms->len != 2 || !kittycat_permission_lists_equal(failing, result.failing_perms) || !kittycat_permission_lists_equal(expected.failing_perms, result.failing_perms))
+            {
+                fprintf(stderr, "kittycat_patch_checker_check returned the wrong failing permissions for case %zu\n", c);
+                return 1;
+            }
+            kittycat_permission_list_free(failing);
+            kittycat_permission_list_free(result.failing_perms);
+            kittycat_permission_list_free(expected.failing_perms);
+        }
+
+        kittycat_permission_list_free(current_perms);
+        kittycat_permission_list_free(new_perms);
+    }
+
+    kittycat_patch_checker_free(checker);
+    kittycat_permission_list_free(manager_perms);
+
+    // Missing negators are reported in the order of the manager's KittycatPermissions, not in atom order. Interning "zzz" first gives it
+    // the smaller atom
+    kittycat_string_intern("patch_checker_zzz", 17);
+    manager_perms = perm_list_from_strs((char *[]){"rpc.*", "~rpc.patch_checker_aaa", "~rpc.patch_checker_zzz"}, 3);
+    checker = kittycat_patch_checker_new(manager_perms);
+    struct KittycatPermissionList *current_perms = kittycat_permission_list_new();
+    struct KittycatPermissionList *new_perms = perm_list_from_strs((char *[]){"rpc.*"}, 1);
+    struct KittycatPermissionList *failing = perm_list_from_strs((char *[]){"rpc.*", "~rpc.patch_checker_aaa"}, 2);
+
+    struct KittycatPermissionCheckPatchChangesResult result = kittycat_patch_checker_check(checker, current_perms, new_perms);
+    struct KittycatPermissionCheckPatchChangesResult expected = kittycat_check_patch_changes(manager_perms, current_perms, new_perms);
+    if (result.state != KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD ||
+        !kittycat_permission_lists_equal(failing, result.failing_perms) || !kittycat_permission_lists_equal(expected.failing_perms, result.failing_perms))
+    {
+        fprintf(stderr, "kittycat_patch_checker_check reported the manager's negators out of order\n");
+        return 1;
+    }
+
+    kittycat_permission_list_free(result.failing_perms);
+    kittycat_permission_list_free(expected.failing_perms);
+    kittycat_permission_list_free(failing);
+    kittycat_permission_list_free(current_perms);
+    kittycat_permission_list_free(new_perms);
+    kittycat_patch_checker_free(checker);
+    kittycat_permission_list_free(manager_perms);
+
+    return 0;
+}
+
+int patch_check_batch__test()
+{
+    struct KittycatPermissionList *manager_perms = perm_list_from_strs((char *[]){"rpc.*", "~rpc.a", "~rpc.b", "bot.a", "~bot.b"}, 5);
+    struct kittycat_patch_checker *checker = kittycat_patch_checker_new(manager_perms);
+
+    // Every failure of a patch is reported, not just the first
+    struct KittycatPermissionList *empty = kittycat_permission_list_new();
+    struct KittycatPermissionList *wide = perm_list_from_strs((char *[]){"rpc.*", "bot.x", "apps.y"}, 3);
+    struct KittycatPatchCheckBatchResult *result = kittycat_patch_checker_check_batch(checker, (const struct KittycatPermissionList *const[]){empty}, (const struct KittycatPermissionList *const[]){wide}, 1, 1);
+    size_t no_permission = 0, lacks_negator = 0;
+    for (size_t i = 0; i < result->len; i++)
+    {
+        no_permission += result->failures[i].reason == KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_NO_PERMISSION;
+        lacks_negator += result->failures[i].reason == KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_LACKS_NEGATOR_FOR_WILDCARD;
+    }
+    if (result->len != 4 || no_permission != 2 || lacks_negator != 2)
+    {
+        fprintf(stderr, "kittycat_patch_checker_check_batch reported %zu failures (%zu without permission, %zu lacking a negator) instead of 4 (2, 2)\n", result->len, no_permission, lacks_negator);
+        return 1;
+    }
+    kittycat_patch_check_batch_result_free(result);
+    kittycat_permission_list_free(empty);
+    kittycat_permission_list_free(wide);
+
+    // Random patches, split between threads. The first failure of each patch is what kittycat_patch_checker_check reports
+    size_t n = 500;
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    char perms[8][32];
+    struct KittycatPermissionList **current = malloc(n * sizeof(struct KittycatPermissionList *));
+    struct KittycatPermissionList **new = malloc(n * sizeof(struct KittycatPermissionList *));
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t len = (rng >> 40) % 5;
+        rng = random_test_perms(rng, perms, len);
+        current[i] = perm_list_from_strs((char *[]){perms[0], perms[1], perms[2], perms[3]}, len);
+
+        len = (rng >> 40) % 8;
+        rng = random_test_perms(rng, perms, len);
+        new[i] = perm_list_from_strs((char *[]){perms[0], perms[1], perms[2], perms[3], perms[4], perms[5], perms[6], perms[7]}, len);
+    }
+
+    for (size_t threads = 1; threads <= 4; threads *= 2)
+    {
+        result = kittycat_patch_checker_check_batch(checker, (const struct KittycatPermissionList *const *)current, (const struct KittycatPermissionList *const *)new, n, threads);
+
+        size_t f = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            struct KittycatPermissionCheckPatchChangesResult expected = kittycat_patch_checker_check(checker, current[i], new[i]);
+            if (f > 0 && f < result->len && result->failures[f].patch < result->failures[f - 1].patch)
+            {
+                fprintf(stderr, "kittycat_patch_checker_check_batch failures are not sorted by patch\n");
+                return 1;
+            }
+
+            bool failed = f < result->len && result->failures[f].patch == i;
+            if (failed != (expected.state != KITTYCAT_PERMISSION_CHECK_PATCH_CHANGES_RESULT_STATE_OK))
+            {
+                fprintf(stderr, "kittycat_patch_checker_check_batch disagrees with kittycat_patch_checker_check on patch %zu with %zu threads\n", i, threads);
+                return 1;
+            }
+
+            if (failed)
+            {
+                struct KittycatPatchFailure *first = &result->failures[f];
+                if (first->reason != expected.state || first->perm != kittycat_permission_pack(expected.failing_perms->perms[0]) ||
+                    (first->negator != 0) != (expected.failing_perms->len == 2) ||
+                    (first->negator != 0 && first->negator != kittycat_permission_pack(expected.failing_perms->perms[1])))
+                {
+                    fprintf(stderr, "kittycat_patch_checker_check_batch reported a different first failure for patch %zu\n", i);
+                    return 1;
+                }
+                kittycat_permission_list_free(expected.failing_perms);
+            }
+
+            while (f < result->len && result->failures[f].patch == i)
+            {
+                f++;
+            }
+        }
+
+        if (f != result->len)
+        {
+            fprintf(stderr, "kittycat_patch_checker_check_batch reported failures for patches that do not exist\n");
+            return 1;
+        }
+        kittycat_patch_check_batch_result_free(result);
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        kittycat_permission_list_free(current[i]);
+        kittycat_permission_list_free(new[i]);
+    }
+    free(current);
+    free(new);
+    kittycat_patch_checker_free(checker);
+    kittycat_permission_list_free(manager_perms);
+
+    return 0;
+}
+
 int main()
 {
-    kittycat_set_allocator(malloc, realloc, free, memcpy);
+    kittycat_set_allocator(counting_malloc, counting_realloc, free, memcpy);
 
     printf("Running tests: %s...\n", ":)");
 
@@ -422,7 +1923,112 @@ int main()
         return rc;
     }
 
+    rc = permission_view__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = has_perms_batch__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = has_perm_multi__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = permission_schema__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = arena__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    resolve_arena = kittycat_arena_new(64);
+
+    rc = sp_resolve_order__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = sp_resolve_reverse__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = position_registry__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = resolve_cache__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = resolve_tracker__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = resolve_batch__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = resolver__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = resolve_to_set__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = staff_has_perm__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = check_patch_changes__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = patch_checker__test();
+    if (rc)
+    {
+        return rc;
+    }
+
+    rc = patch_check_batch__test();
+    if (rc)
+    {
+        return rc;
+    }
+
     rc = sp_resolve__test();
+    kittycat_arena_free(resolve_arena);
     if (rc)
     {
         return rc;